@@ -757,6 +757,7 @@ typedef enum {
     UNCOMPRESSED_R32,               // 32 bpp (1 channel - float)
     UNCOMPRESSED_R32G32B32,         // 32*3 bpp (3 channels - float)
     UNCOMPRESSED_R32G32B32A32,      // 32*4 bpp (4 channels - float)
+    UNCOMPRESSED_R16,               // 16 bpp (1 channel - unsigned normalized, GPU textures only)
     COMPRESSED_DXT1_RGB,            // 4 bpp (no alpha)
     COMPRESSED_DXT1_RGBA,           // 4 bpp (1 bit alpha)
     COMPRESSED_DXT3_RGBA,           // 8 bpp
@@ -1180,6 +1181,7 @@ RLAPI RenderTexture2D LoadRenderTexture(int width, int height);
 RLAPI void UnloadTexture(Texture2D texture);                                                             // Unload texture from GPU memory (VRAM)
 RLAPI void UnloadRenderTexture(RenderTexture2D target);                                                  // Unload render texture from GPU memory (VRAM)
 RLAPI void UpdateTexture(Texture2D texture, const void *pixels);                                         // Update GPU texture with new data
+RLAPI void UpdateTextureRec(Texture2D texture, Rectangle rec, const void *pixels);                       // Update GPU texture rectangle with new data
 RLAPI Image GetTextureData(Texture2D texture);                                                           // Get pixel data from GPU texture and return an Image
 RLAPI Image GetScreenData(void);                                                                         // Get pixel data from screen buffer and return an Image (screenshot)
 
@@ -343,6 +343,7 @@ typedef unsigned char byte;
         UNCOMPRESSED_R32,               // 32 bpp (1 channel - float)
         UNCOMPRESSED_R32G32B32,         // 32*3 bpp (3 channels - float)
         UNCOMPRESSED_R32G32B32A32,      // 32*4 bpp (4 channels - float)
+        UNCOMPRESSED_R16,               // 16 bpp (1 channel - unsigned normalized, GPU textures only)
         COMPRESSED_DXT1_RGB,            // 4 bpp (no alpha)
         COMPRESSED_DXT1_RGBA,           // 4 bpp (1 bit alpha)
         COMPRESSED_DXT3_RGBA,           // 8 bpp
@@ -517,10 +518,17 @@ RLAPI Vector3 rlUnproject(Vector3 source, Matrix proj, Matrix view);  // Get wor
 RLAPI unsigned int rlLoadTexture(void *data, int width, int height, int format, int mipmapCount); // Load texture in GPU
 RLAPI unsigned int rlLoadTextureDepth(int width, int height, int bits, bool useRenderBuffer);     // Load depth texture/renderbuffer (to be attached to fbo)
 RLAPI unsigned int rlLoadTextureCubemap(void *data, int size, int format);                        // Load texture cubemap
-RLAPI void rlUpdateTexture(unsigned int id, int width, int height, int format, const void *data); // Update GPU texture with new data
+RLAPI void rlUpdateTexture(unsigned int id, int offsetX, int offsetY, int width, int height, int format, const void *data); // Update GPU texture with new data
 RLAPI void rlGetGlTextureFormats(int format, unsigned int *glInternalFormat, unsigned int *glFormat, unsigned int *glType);  // Get OpenGL internal formats
 RLAPI void rlUnloadTexture(unsigned int id);                              // Unload texture from GPU memory
 
+// Pixel buffer management (asynchronous texture updates)
+RLAPI unsigned int rlLoadPixelBuffer(int size);                           // Load a pixel unpack buffer in GPU (returns 0 if not supported)
+RLAPI void *rlMapPixelBuffer(unsigned int id, int size);                  // Map pixel buffer for writing, previous content is discarded
+RLAPI void rlUnmapPixelBuffer(unsigned int id);                           // Unmap pixel buffer, required before updating textures from it
+RLAPI void rlUpdateTextureFromPixelBuffer(unsigned int id, unsigned int bufferId, int bufferOffset, int offsetX, int offsetY, int width, int height, int format); // Update GPU texture with data from a pixel buffer
+RLAPI void rlUnloadPixelBuffer(unsigned int id);                          // Unload pixel buffer from GPU memory
+
 RLAPI void rlGenerateMipmaps(Texture2D *texture);                         // Generate mipmap data for selected texture
 RLAPI void *rlReadTexturePixels(Texture2D texture);                       // Read texture pixel data
 RLAPI unsigned char *rlReadScreenPixels(int width, int height);           // Read screen pixel data (color buffer)
@@ -1940,7 +1948,7 @@ unsigned int rlLoadTexture(void *data, int width, int height, int format, int mi
         #endif
 
         #if defined(GRAPHICS_API_OPENGL_33)
-            if (format == UNCOMPRESSED_GRAYSCALE)
+            if ((format == UNCOMPRESSED_GRAYSCALE) || (format == UNCOMPRESSED_R16))
             {
                 GLint swizzleMask[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
                 glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
@@ -2129,7 +2137,7 @@ unsigned int rlLoadTextureCubemap(void *data, int size, int format)
 
 // Update already loaded texture in GPU with new data
 // NOTE: We don't know safely if internal texture format is the expected one...
-void rlUpdateTexture(unsigned int id, int width, int height, int format, const void *data)
+void rlUpdateTexture(unsigned int id, int offsetX, int offsetY, int width, int height, int format, const void *data)
 {
     glBindTexture(GL_TEXTURE_2D, id);
 
@@ -2138,7 +2146,7 @@ void rlUpdateTexture(unsigned int id, int width, int height, int format, const v
 
     if ((glInternalFormat != -1) && (format < COMPRESSED_DXT1_RGB))
     {
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, glFormat, glType, (unsigned char *)data);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, offsetX, offsetY, width, height, glFormat, glType, (unsigned char *)data);
     }
     else TRACELOG(LOG_WARNING, "TEXTURE: [ID %i] Failed to update for current texture format (%i)", id, format);
 }
@@ -2177,6 +2185,7 @@ void rlGetGlTextureFormats(int format, unsigned int *glInternalFormat, unsigned
         case UNCOMPRESSED_R32: if (RLGL.ExtSupported.texFloat32) *glInternalFormat = GL_R32F; *glFormat = GL_RED; *glType = GL_FLOAT; break;
         case UNCOMPRESSED_R32G32B32: if (RLGL.ExtSupported.texFloat32) *glInternalFormat = GL_RGB32F; *glFormat = GL_RGB; *glType = GL_FLOAT; break;
         case UNCOMPRESSED_R32G32B32A32: if (RLGL.ExtSupported.texFloat32) *glInternalFormat = GL_RGBA32F; *glFormat = GL_RGBA; *glType = GL_FLOAT; break;
+        case UNCOMPRESSED_R16: *glInternalFormat = GL_R16; *glFormat = GL_RED; *glType = GL_UNSIGNED_SHORT; break;
     #endif
         #if !defined(GRAPHICS_API_OPENGL_11)
         case COMPRESSED_DXT1_RGB: if (RLGL.ExtSupported.texCompDXT) *glInternalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
@@ -2201,6 +2210,74 @@ void rlUnloadTexture(unsigned int id)
     if (id > 0) glDeleteTextures(1, &id);
 }
 
+// Load a pixel unpack buffer in GPU
+// NOTE: Textures updated from a pixel buffer return immediately, data is transferred asynchronously by the driver
+unsigned int rlLoadPixelBuffer(int size)
+{
+    unsigned int id = 0;
+
+#if defined(GRAPHICS_API_OPENGL_33)
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, id);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+
+    return id;
+}
+
+// Map pixel buffer for writing
+// NOTE: Buffer is invalidated, so mapping doesn't wait for the GPU to finish reading the previous content
+void *rlMapPixelBuffer(unsigned int id, int size)
+{
+    void *data = NULL;
+
+#if defined(GRAPHICS_API_OPENGL_33)
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, id);
+    data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+
+    return data;
+}
+
+// Unmap pixel buffer
+void rlUnmapPixelBuffer(unsigned int id)
+{
+#if defined(GRAPHICS_API_OPENGL_33)
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, id);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+}
+
+// Update GPU texture rectangle with data from a pixel buffer, starting at bufferOffset bytes
+void rlUpdateTextureFromPixelBuffer(unsigned int id, unsigned int bufferId, int bufferOffset, int offsetX, int offsetY, int width, int height, int format)
+{
+#if defined(GRAPHICS_API_OPENGL_33)
+    glBindTexture(GL_TEXTURE_2D, id);
+
+    unsigned int glInternalFormat, glFormat, glType;
+    rlGetGlTextureFormats(format, &glInternalFormat, &glFormat, &glType);
+
+    if ((glInternalFormat != -1) && (format < COMPRESSED_DXT1_RGB))
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bufferId);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, offsetX, offsetY, width, height, glFormat, glType, (void *)(size_t)bufferOffset); // Data pointer is an offset in the bound buffer
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else TRACELOG(LOG_WARNING, "TEXTURE: [ID %i] Failed to update for current texture format (%i)", id, format);
+#endif
+}
+
+// Unload pixel buffer from GPU memory
+void rlUnloadPixelBuffer(unsigned int id)
+{
+#if defined(GRAPHICS_API_OPENGL_33)
+    if (id > 0) glDeleteBuffers(1, &id);
+#endif
+}
+
 // Load a texture to be used for rendering (fbo with default color and depth attachments)
 // NOTE: If colorFormat or depthBits are no supported, no attachment is done
 RenderTexture2D rlLoadRenderTexture(int width, int height, int format, int depthBits, bool useDepthTexture)
@@ -4665,6 +4742,7 @@ int GetPixelDataSize(int width, int height, int format)
         case UNCOMPRESSED_R32: bpp = 32; break;
         case UNCOMPRESSED_R32G32B32: bpp = 32*3; break;
         case UNCOMPRESSED_R32G32B32A32: bpp = 32*4; break;
+        case UNCOMPRESSED_R16: bpp = 16; break;
         case COMPRESSED_DXT1_RGB:
         case COMPRESSED_DXT1_RGBA:
         case COMPRESSED_ETC1_RGB:
@@ -732,6 +732,7 @@ int GetPixelDataSize(int width, int height, int format)
         case UNCOMPRESSED_R32: bpp = 32; break;
         case UNCOMPRESSED_R32G32B32: bpp = 32*3; break;
         case UNCOMPRESSED_R32G32B32A32: bpp = 32*4; break;
+        case UNCOMPRESSED_R16: bpp = 16; break;
         case COMPRESSED_DXT1_RGB:
         case COMPRESSED_DXT1_RGBA:
         case COMPRESSED_ETC1_RGB:
@@ -801,7 +802,14 @@ Image GetScreenData(void)
 // NOTE: pixels data must match texture.format
 void UpdateTexture(Texture2D texture, const void *pixels)
 {
-    rlUpdateTexture(texture.id, texture.width, texture.height, texture.format, pixels);
+    rlUpdateTexture(texture.id, 0, 0, texture.width, texture.height, texture.format, pixels);
+}
+
+// Update GPU texture rectangle with new data
+// NOTE: pixels data must match texture.format
+void UpdateTextureRec(Texture2D texture, Rectangle rec, const void *pixels)
+{
+    rlUpdateTexture(texture.id, rec.x, rec.y, rec.width, rec.height, texture.format, pixels);
 }
 
 // Export image data to file
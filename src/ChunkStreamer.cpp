@@ -0,0 +1,252 @@
+#include "ChunkStreamer.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "NormalMap.h"
+#include "ThreadPool.h"
+
+#define CHUNK_ISLAND_SIZE		32.0f // world units across the island, NormalMap scales the normals to it
+#define CHUNK_BEHIND_WEIGHT		2.0f // distance multiplier of a chunk straight behind the camera, chunks in the view direction come first
+
+// droplet seed of a chunk, neighbors get unrelated sequences
+static unsigned int ChunkSeed(unsigned int seed, ChunkCoord coord)
+{
+	unsigned int hash = seed ^ ((unsigned int)coord.x * 0x8DA6B343u) ^ ((unsigned int)coord.z * 0xD8163841u);
+	hash = (hash ^ (hash >> 15)) * 0x7FEB352Du;
+	hash = (hash ^ (hash >> 16)) * 0x846CA68Bu;
+	return hash ^ (hash >> 16);
+}
+
+ChunkStreamer::ChunkStreamer(const ChunkSettings& settings) : settings(settings)
+{
+	int threads = (settings.workerThreads <= 0) ? std::max(ThreadPool::GetHardwareThreadCount() - 1, 1) : settings.workerThreads;
+	for (int i = 0; i < threads; i++)
+	{
+		workers.push_back(std::thread(&ChunkStreamer::WorkerLoop, this));
+	}
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	chunkQueued.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+size_t ChunkStreamer::GetChunkBytes(const ChunkSettings& settings)
+{
+	size_t cells = (size_t)(settings.chunkCells + 1) * (settings.chunkCells + 1);
+	return sizeof(TerrainChunk) + cells * (sizeof(unsigned short) + NormalMap::TEXEL_BYTES);
+}
+
+Vector3 ChunkStreamer::GetChunkCenter(ChunkCoord coord) const
+{
+	float size = GetChunkSize();
+	return { (coord.x + 0.5f) * size, 0.0f, (coord.z + 0.5f) * size };
+}
+
+void ChunkStreamer::GenerateChunk(ErosionMaker* erosionMaker, const ChunkSettings& settings, ChunkCoord coord, TerrainChunk* chunk)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	int halo = settings.haloCells;
+	int extent = settings.chunkCells + 2 * halo + 1; // the chunk and its halo
+	size_t cells = (size_t)extent * extent;
+
+	// the noise of the world cells: offsets are whole cells and the scale is the same for every chunk, so a cell gets the
+	// same height in every chunk that covers it
+	NoiseParameters noise = settings.noise;
+	noise.seed = settings.seed;
+	noise.scale = extent / settings.noisePeriod;
+	noise.offsetX = (float)((long long)coord.x * settings.chunkCells - halo);
+	noise.offsetY = (float)((long long)coord.z * settings.chunkCells - halo);
+	std::vector<float> base(cells);
+	erosionMaker->GenerateNoise(base.data(), extent, extent, noise);
+	erosionMaker->remapCurve.Apply(base.data(), (int)cells); // flattened beaches, no island gradient
+
+	std::vector<float> map = base;
+	erosionMaker->SetSeed(ChunkSeed(settings.seed, coord));
+	erosionMaker->Erode(&map, extent, extent, settings.droplets, false);
+
+	// the erosion fades out towards the border of the chunk, on both sides of it: the edge and the cells next to it keep
+	// the noise, so the edge heights and their normals are the ones of the neighbor
+	int first = halo;
+	int last = halo + settings.chunkCells;
+	float seam = (float)std::max(settings.seamCells, 1);
+	for (int y = 0; y < extent; y++)
+	{
+		int distanceY = std::min(abs(y - first), abs(y - last));
+		for (int x = 0; x < extent; x++)
+		{
+			int distance = std::min(distanceY, std::min(abs(x - first), abs(x - last)));
+			float t = std::min(std::max((distance - 1) / seam, 0.0f), 1.0f);
+			float weight = t * t * (3.0f - 2.0f * t);
+			size_t i = (size_t)y * extent + x;
+			map[i] = base[i] + (map[i] - base[i]) * weight;
+		}
+	}
+
+	NormalMap normals(extent, extent, (int)lroundf(CHUNK_ISLAND_SIZE / settings.cellSize));
+	normals.Calculate(map, erosionMaker->parameters.threadCount);
+
+	// crop the chunk
+	int side = settings.chunkCells + 1;
+	chunk->coord = coord;
+	chunk->heights.resize((size_t)side * side);
+	chunk->normals.resize((size_t)side * side * NormalMap::TEXEL_BYTES);
+	chunk->minHeight = 1.0f;
+	chunk->maxHeight = 0.0f;
+	for (int y = 0; y < side; y++)
+	{
+		const float* row = map.data() + (size_t)(first + y) * extent + first;
+		ErosionMaker::EncodeHeights(row, chunk->heights.data() + (size_t)y * side, side);
+		memcpy(chunk->normals.data() + (size_t)y * side * NormalMap::TEXEL_BYTES,
+			normals.GetTexels() + ((size_t)(first + y) * extent + first) * NormalMap::TEXEL_BYTES, (size_t)side * NormalMap::TEXEL_BYTES);
+		for (int x = 0; x < side; x++)
+		{
+			chunk->minHeight = std::min(chunk->minHeight, row[x]);
+			chunk->maxHeight = std::max(chunk->maxHeight, row[x]);
+		}
+	}
+	chunk->seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count() / 1000000000.0f;
+}
+
+void ChunkStreamer::SetView(Vector3 position, Vector3 direction)
+{
+	// chunks whose center is within the view distance, the ones behind the camera count as further away
+	float size = GetChunkSize();
+	float distance = settings.viewDistance;
+	float length = sqrtf(direction.x * direction.x + direction.z * direction.z);
+	float forwardX = (length > 0.0f) ? direction.x / length : 0.0f;
+	float forwardZ = (length > 0.0f) ? direction.z / length : 0.0f;
+	int firstX = (int)floorf((position.x - distance) / size);
+	int lastX = (int)floorf((position.x + distance) / size);
+	int firstZ = (int)floorf((position.z - distance) / size);
+	int lastZ = (int)floorf((position.z + distance) / size);
+	std::vector<std::pair<float, ChunkCoord>> candidates;
+	for (int z = firstZ; z <= lastZ; z++)
+	{
+		for (int x = firstX; x <= lastX; x++)
+		{
+			Vector3 center = GetChunkCenter({ x, z });
+			float dx = center.x - position.x;
+			float dz = center.z - position.z;
+			float centerDistance = sqrtf(dx * dx + dz * dz);
+			if (centerDistance > distance)
+				continue;
+			float facing = (centerDistance > 0.0f) ? (dx * forwardX + dz * forwardZ) / centerDistance : 1.0f;
+			float weight = 1.0f + (CHUNK_BEHIND_WEIGHT - 1.0f) * (1.0f - facing) / 2.0f;
+			candidates.push_back({ centerDistance * weight, { x, z } });
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, ChunkCoord>& a, const std::pair<float, ChunkCoord>& b) { return a.first < b.first; });
+	// no more than the cache holds, or the chunks would evict each other and be generated again and again
+	size_t capacity = std::max(settings.memoryBudget / GetChunkBytes(settings), (size_t)1);
+	candidates.resize(std::min(candidates.size(), capacity));
+	wanted.clear();
+	for (const std::pair<float, ChunkCoord>& candidate : candidates)
+	{
+		wanted.push_back(candidate.second);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.clear();
+		wantedKeys.clear();
+		// the wanted chunks are used from back to front, the highest priority ends up most recently used
+		for (size_t i = wanted.size(); i-- > 0;)
+		{
+			long long key = Key(wanted[i]);
+			wantedKeys.insert(key);
+			std::map<long long, CacheEntry>::iterator entry = cache.find(key);
+			if (entry != cache.end())
+				useOrder.splice(useOrder.begin(), useOrder, entry->second.use);
+		}
+		for (const ChunkCoord& coord : wanted)
+		{
+			long long key = Key(coord);
+			if (cache.find(key) == cache.end() && generating.find(key) == generating.end())
+				queue.push_back(coord);
+		}
+	}
+	chunkQueued.notify_all();
+}
+
+std::shared_ptr<const TerrainChunk> ChunkStreamer::GetChunk(ChunkCoord coord)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::map<long long, CacheEntry>::iterator entry = cache.find(Key(coord));
+	if (entry == cache.end())
+		return nullptr;
+	return entry->second.chunk;
+}
+
+ChunkStreamerStatistics ChunkStreamer::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	ChunkStreamerStatistics statistics;
+	statistics.cached = (int)cache.size();
+	statistics.cachedBytes = cachedBytes;
+	statistics.wanted = (int)wantedKeys.size();
+	statistics.queued = (int)queue.size();
+	statistics.generating = (int)generating.size();
+	statistics.generated = generated;
+	statistics.evicted = evicted;
+	statistics.averageSeconds = (generated > 0) ? (float)(generationSeconds / generated) : 0.0f;
+	return statistics;
+}
+
+void ChunkStreamer::Insert(const std::shared_ptr<const TerrainChunk>& chunk)
+{
+	long long key = Key(chunk->coord);
+	// a chunk that went out of view while it was generated is the first to go
+	bool isWanted = wantedKeys.find(key) != wantedKeys.end();
+	CacheEntry entry;
+	entry.chunk = chunk;
+	entry.use = useOrder.insert(isWanted ? useOrder.begin() : useOrder.end(), key);
+	cache[key] = entry;
+	cachedBytes += GetChunkBytes(settings);
+	while (cachedBytes > settings.memoryBudget && cache.size() > 1)
+	{
+		cache.erase(useOrder.back());
+		useOrder.pop_back();
+		cachedBytes -= GetChunkBytes(settings);
+		evicted++;
+	}
+}
+
+void ChunkStreamer::WorkerLoop()
+{
+	// a maker per worker, chunks are eroded on a single thread each and the workers run side by side
+	ErosionParameters parameters = settings.erosion;
+	parameters.threadCount = 1;
+	ErosionMaker erosionMaker(parameters);
+	while (true)
+	{
+		ChunkCoord coord;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			chunkQueued.wait(lock, [this] { return quit || !queue.empty(); });
+			if (quit)
+				return;
+			coord = queue.front();
+			queue.pop_front();
+			generating.insert(Key(coord));
+		}
+
+		std::shared_ptr<TerrainChunk> chunk = std::make_shared<TerrainChunk>();
+		GenerateChunk(&erosionMaker, settings, coord, chunk.get());
+
+		std::lock_guard<std::mutex> lock(mutex);
+		generating.erase(Key(coord));
+		Insert(chunk);
+		generated++;
+		generationSeconds += chunk->seconds;
+	}
+}
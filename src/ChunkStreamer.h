@@ -0,0 +1,118 @@
+#ifndef CHUNK_STREAMER
+#define CHUNK_STREAMER
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "raylib.h"
+#include "ErosionMaker.h"
+
+// position of a chunk in the grid of streamed terrain, chunk (0, 0) starts at the world origin
+typedef struct
+{
+	int x, z;
+} ChunkCoord;
+
+// streamed terrain settings, every chunk of a streamer is generated with the same ones
+typedef struct
+{
+	int chunkCells = 128; // cells along a side of a chunk, its heightmap has chunkCells + 1 heights per side (neighbors share the edge)
+	int haloCells = 32; // cells generated and eroded around a chunk so droplets crossing its border are simulated, cropped afterwards
+	int seamCells = 8; // cells over which the erosion fades out towards the border of a chunk, neighbors meet on the uneroded heights
+	float cellSize = 1.0f / 16.0f; // world units per cell, the cells of the default 512 island
+	float noisePeriod = 128.0f; // cells per period of the base octave, the noise of the default island
+	int droplets = 10000; // eroded per chunk, on the chunk and its halo (a little under the density of 100000 on the 512 island)
+	float viewDistance = 48.0f; // world units, the chunks whose center is closer to the camera are streamed
+	size_t memoryBudget = (size_t)64 << 20; // bytes of the finished chunks cached, the view distance is cut to the chunks that fit
+	int workerThreads = 0; // 0 = hardware threads - 1
+	unsigned int seed = 0; // noise and droplets
+	NoiseParameters noise; // type, octaves, lacunarity and gain of the noise (seed, scale and offsets are set per chunk)
+	ErosionParameters erosion; // droplet parameters, chunks are eroded on a single thread each
+} ChunkSettings;
+
+// a finished chunk: heights and normals of its (chunkCells + 1)^2 cells, ready to upload
+typedef struct
+{
+	ChunkCoord coord;
+	std::vector<unsigned short> heights; // encoded by ErosionMaker::EncodeHeights, row-major (rows along z)
+	std::vector<unsigned char> normals; // NormalMap texels
+	float minHeight, maxHeight; // range (0, 1)
+	float seconds; // spent generating it
+} TerrainChunk;
+
+typedef struct
+{
+	int cached; // finished chunks in the cache
+	size_t cachedBytes;
+	int wanted; // chunks around the camera, as of the last SetView
+	int queued; // wanted chunks waiting for a worker
+	int generating;
+	long long generated; // since the streamer was created
+	long long evicted;
+	float averageSeconds; // generation time of a chunk on its worker
+} ChunkStreamerStatistics;
+
+// generates terrain chunks around the camera on its own worker threads: world-continuous noise, remap and droplet
+// erosion of the chunk and a halo around it, normals, cropped to the chunk. the erosion fades out near the chunk border
+// so neighbors share their edge heights and normals bit for bit, whichever was generated first or on which thread.
+// finished chunks go to an LRU cache bounded by a memory budget. SetView queues the missing chunks within the view
+// distance, those in the view direction first, and drops the queued ones that went out of it. nothing the render loop
+// calls waits for a chunk: it polls GetChunk and uploads the ones that are there
+class ChunkStreamer
+{
+public:
+	explicit ChunkStreamer(const ChunkSettings& settings); // starts the workers
+	~ChunkStreamer(); // waits for the chunks being generated and stops the workers
+
+	ChunkStreamer(ChunkStreamer const&) = delete;
+	void operator=(ChunkStreamer const&) = delete;
+
+	// world position and view direction of the camera: wanted chunks become the ones within the view distance, by priority
+	void SetView(Vector3 position, Vector3 direction);
+	const std::vector<ChunkCoord>& GetWantedChunks() const { return wanted; } // as of the last SetView, highest priority first
+	std::shared_ptr<const TerrainChunk> GetChunk(ChunkCoord coord); // the finished chunk from the cache, nullptr while it isn't there
+	ChunkStreamerStatistics GetStatistics();
+	const ChunkSettings& GetSettings() const { return settings; }
+	float GetChunkSize() const { return settings.chunkCells * settings.cellSize; } // world units along a side
+	Vector3 GetChunkCenter(ChunkCoord coord) const; // world, at height 0
+
+	// the chunk pipeline on the calling thread, erosionMaker erodes on parameters.threadCount threads (deterministic)
+	static void GenerateChunk(ErosionMaker* erosionMaker, const ChunkSettings& settings, ChunkCoord coord, TerrainChunk* chunk);
+	static size_t GetChunkBytes(const ChunkSettings& settings); // memory of a finished chunk
+
+private:
+	typedef struct
+	{
+		std::shared_ptr<const TerrainChunk> chunk;
+		std::list<long long>::iterator use; // position in the use order
+	} CacheEntry;
+
+	static long long Key(ChunkCoord coord) { return ((long long)coord.x << 32) | (unsigned int)coord.z; }
+	void WorkerLoop();
+	void Insert(const std::shared_ptr<const TerrainChunk>& chunk); // adds a finished chunk and evicts over the budget, under the mutex
+
+	ChunkSettings settings;
+	std::vector<std::thread> workers;
+	std::vector<ChunkCoord> wanted; // only touched by the caller of SetView
+
+	std::mutex mutex; // guards everything below
+	std::condition_variable chunkQueued;
+	std::deque<ChunkCoord> queue; // missing wanted chunks by priority
+	std::set<long long> wantedKeys;
+	std::set<long long> generating;
+	std::map<long long, CacheEntry> cache;
+	std::list<long long> useOrder; // most recently used first
+	size_t cachedBytes = 0;
+	long long generated = 0;
+	long long evicted = 0;
+	double generationSeconds = 0.0;
+	bool quit = false;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "ErosionBatch.h"
+#include <climits>
+#include <algorithm>
+#include <chrono>
+#include "ThreadPool.h"
+
+#define BATCH_ERODE_DROPLETS	(1 << 20) // droplets per Erode call, bounds the spawn arrays of a job
+#define BATCH_SPAWN_BYTES		20 // spawn arrays of Erode per droplet of a call: tile (4), spawn (8) and sorted spawn (8)
+#define BATCH_PIPE_FIELDS		11 // per-cell fields of the virtual pipe model
+#define BATCH_THERMAL_FIELDS	2 // per-cell fields of thermal erosion
+#define BATCH_WRITE_BYTES		4 // per cell, largest conversion buffers of the writers (16 bit samples and their bytes)
+
+// rough run time of a job in cell visits: droplet steps plus the full-map passes, a pipe or thermal iteration passes over every cell
+static double EstimateJobCost(const MapJob& job)
+{
+	double cells = (double)job.mapWidth * job.mapHeight;
+	double thermal = cells * job.thermalIterations;
+	if (job.parameters.model == ErosionModel::PIPES)
+		return cells * std::max(job.droplets, 1ll) + thermal;
+	return (double)job.droplets * job.parameters.maxDropletLifetime + cells + thermal;
+}
+
+size_t ErosionBatch::EstimateJobBytes(const MapJob& job)
+{
+	size_t cells = (size_t)job.mapWidth * job.mapHeight;
+	size_t bytes = cells * sizeof(float); // the map
+	bytes += cells * BATCH_WRITE_BYTES;
+	const ErosionParameters& parameters = job.parameters;
+	if (parameters.model == ErosionModel::PIPES)
+	{
+		bytes += cells * sizeof(float) * BATCH_PIPE_FIELDS;
+	}
+	else
+	{
+		long long callDroplets = std::min(job.droplets, (long long)BATCH_ERODE_DROPLETS);
+		bytes += (size_t)callDroplets * BATCH_SPAWN_BYTES;
+		if (parameters.layout == HeightmapLayout::TILED && parameters.kernel == ErosionKernel::SCALAR)
+			bytes += cells * sizeof(float); // tiled copy of the map, blocks round it up a little
+	}
+	if (job.thermalIterations > 0)
+		bytes += cells * sizeof(float) * BATCH_THERMAL_FIELDS; // kept by the maker next to the pipe fields
+	if (job.multiresolutionLevels > 0)
+		bytes += cells * sizeof(float); // coarse originals (a third of the map), eroded level and its change (a quarter each)
+	return bytes;
+}
+
+void ErosionBatch::Reserve(size_t bytes)
+{
+	std::unique_lock<std::mutex> lock(memoryMutex);
+	memoryReleased.wait(lock, [this, bytes] { return reservedBytes == 0 || memoryBudget == 0 || reservedBytes + bytes <= memoryBudget; });
+	reservedBytes += bytes;
+	peakReservedBytes = std::max(peakReservedBytes, reservedBytes);
+}
+
+void ErosionBatch::Release(size_t bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(memoryMutex);
+		reservedBytes -= bytes;
+	}
+	memoryReleased.notify_all();
+}
+
+void ErosionBatch::ReportJob(int jobIndex, const MapJobResult& result)
+{
+	if (!jobFinished)
+		return;
+	std::lock_guard<std::mutex> lock(reportMutex);
+	jobFinished(jobIndex, result);
+}
+
+MapJobResult ErosionBatch::RunJob(const MapJob& job, bool intraMap)
+{
+	MapJobResult result;
+	result.intraMap = intraMap;
+	result.estimatedBytes = EstimateJobBytes(job);
+	Reserve(result.estimatedBytes);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	// a maker per job: jobs on other threads never share its state, the brushes come from the shared cache
+	ErosionParameters parameters = job.parameters;
+	parameters.threadCount = intraMap ? threadCount : 1;
+	ErosionMaker erosionMaker(parameters);
+	if (job.remapCurve)
+		erosionMaker.remapCurve = *job.remapCurve;
+	{
+		std::vector<float> map((size_t)job.mapWidth * job.mapHeight);
+		if (generateNoise)
+			generateNoise(job, &map);
+		else
+			erosionMaker.GenerateNoise(map.data(), job.mapWidth, job.mapHeight, job.noise);
+		erosionMaker.ShapeIsland(map.data(), map.data(), nullptr, job.mapWidth, job.mapHeight, job.gradient);
+		erosionMaker.SetSeed(job.seed);
+		if (job.multiresolutionLevels > 0)
+		{
+			int droplets = (int)std::min(job.droplets, (long long)INT_MAX);
+			result.droplets = erosionMaker.ErodeMultiresolution(&map, job.mapWidth, job.mapHeight, droplets, job.multiresolutionLevels).done;
+		}
+		else
+		{
+			while (result.droplets < job.droplets)
+			{
+				int batch = (int)std::min((long long)BATCH_ERODE_DROPLETS, job.droplets - result.droplets);
+				erosionMaker.Erode(&map, job.mapWidth, job.mapHeight, batch, false);
+				result.droplets += batch;
+			}
+		}
+		if (job.thermalIterations > 0)
+			erosionMaker.ErodeThermal(&map, job.mapWidth, job.mapHeight, job.thermalIterations);
+		result.written = writeMap(job, map);
+	}
+
+	result.seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count() / 1000000000.0;
+	Release(result.estimatedBytes);
+	return result;
+}
+
+std::vector<MapJobResult> ErosionBatch::Run(const std::vector<MapJob>& jobs)
+{
+	std::vector<MapJobResult> results(jobs.size());
+	reservedBytes = 0;
+	peakReservedBytes = 0;
+
+	std::vector<int> largeJobs;
+	std::vector<int> smallJobs;
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		if ((long long)jobs[i].mapWidth * jobs[i].mapHeight >= intraMapCells)
+			largeJobs.push_back((int)i);
+		else
+			smallJobs.push_back((int)i);
+	}
+
+	// large maps one after the other, each spreads its droplet tiles over the pool
+	for (int job : largeJobs)
+	{
+		results[job] = RunJob(jobs[job], true);
+		ReportJob(job, results[job]);
+	}
+
+	// small maps a job per thread, the erosion of a map runs inline on its thread (ParallelFor calls made from a task are serial).
+	// the costliest jobs go first so the last ones to start are short and the threads finish together
+	std::stable_sort(smallJobs.begin(), smallJobs.end(), [&jobs](int a, int b) { return EstimateJobCost(jobs[a]) > EstimateJobCost(jobs[b]); });
+	ThreadPool::GetInstance().ParallelFor((int)smallJobs.size(), threadCount, [&](int index, int worker)
+	{
+		int job = smallJobs[index];
+		results[job] = RunJob(jobs[job], false);
+		ReportJob(job, results[job]);
+	});
+	return results;
+}
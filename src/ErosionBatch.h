@@ -0,0 +1,72 @@
+#ifndef EROSION_BATCH
+#define EROSION_BATCH
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ErosionMaker.h"
+
+// a map of a batch: the headless pipeline (noise, gradient, remap, erosion) with its own seed, shape and parameters
+typedef struct
+{
+	unsigned int seed = 0; // droplet sequence
+	NoiseParameters noise; // base heights when the batch has no generateNoise
+	int mapWidth = 512;
+	int mapHeight = 512;
+	GradientType gradient = GradientType::SQUARE;
+	long long droplets = 1000000; // time steps with the PIPES model
+	int multiresolutionLevels = 0; // 0 = flat erosion, otherwise levels of ErodeMultiresolution (droplets only)
+	int thermalIterations = 0; // ErodeThermal after the erosion
+	ErosionParameters parameters; // threadCount is set by the batch
+	std::shared_ptr<const RemapCurve> remapCurve; // curve of the island shaping, nullptr = the beach curve
+	std::string outputPath;
+} MapJob;
+
+// what happened to a job of the batch
+typedef struct
+{
+	bool written = false; // writeMap succeeded
+	bool intraMap = false; // ran alone with every thread of the batch on its map, otherwise on a single thread
+	long long droplets = 0; // simulated (pipe iterations with the PIPES model)
+	size_t estimatedBytes = 0; // memory reserved for the job by the admission control
+	double seconds = 0.0; // from admission to written
+} MapJobResult;
+
+// runs many independent maps through their own erosion makers on the thread pool. small maps don't scale on the droplet
+// tiles of a single map, they run one job per thread with the map's erosion serial on that thread. large maps (at least
+// intraMapCells cells) run one at a time with the whole pool working on the map. jobs are only started while the memory
+// estimated for the jobs running stays within memoryBudget, which bounds the peak memory of the batch
+class ErosionBatch
+{
+public:
+	// base heights of the job in (0, 1), called from any pool thread. optional, ErosionMaker::GenerateNoise of job.noise when not set
+	std::function<void(const MapJob& job, std::vector<float>* map)> generateNoise;
+	std::function<bool(const MapJob& job, const std::vector<float>& map)> writeMap; // saves the eroded map, false on failure, called from any pool thread
+	std::function<void(int jobIndex, const MapJobResult& result)> jobFinished; // optional, called as jobs end, one call at a time
+
+	int threadCount = 0; // threads of the batch, 0 = all hardware threads
+	size_t memoryBudget = (size_t)2048 << 20; // bytes the jobs running at once may use, 0 = unlimited. a job larger than the budget runs alone
+	long long intraMapCells = 1024 * 1024; // maps with at least this many cells use the pool for their own erosion
+
+	std::vector<MapJobResult> Run(const std::vector<MapJob>& jobs); // runs every job, results in the order of jobs
+	size_t GetPeakReservedBytes() const { return peakReservedBytes; } // largest total estimate admitted at once by the last Run
+
+	static size_t EstimateJobBytes(const MapJob& job); // map, erosion maker buffers and droplet scratch of a job at its peak
+
+private:
+	MapJobResult RunJob(const MapJob& job, bool intraMap);
+	void Reserve(size_t bytes); // blocks until the bytes fit in the budget, or nothing else runs
+	void Release(size_t bytes);
+	void ReportJob(int jobIndex, const MapJobResult& result);
+
+	std::mutex memoryMutex;
+	std::condition_variable memoryReleased;
+	size_t reservedBytes = 0;
+	size_t peakReservedBytes = 0;
+	std::mutex reportMutex;
+};
+
+#endif
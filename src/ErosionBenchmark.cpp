@@ -0,0 +1,355 @@
+#include "ErosionBenchmark.h"
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include "ChunkStreamer.h"
+#include "ThreadPool.h"
+
+#define BENCHMARK_ERODE_DROPLETS	20000 // droplets of a run of the Erode cases
+#define BENCHMARK_MAP_SIZE			1024 // map of the cases that don't vary the size
+#define BENCHMARK_SAMPLES			(1 << 20) // positions sampled by the height and gradient cases
+
+static volatile float benchmarkSink; // results of the read-only cases end here, so they aren't optimized away
+
+static const char* GetKernelName(ErosionKernel kernel)
+{
+	return (kernel == ErosionKernel::PACKET) ? "packet" : "scalar";
+}
+
+static const char* GetLayoutName(HeightmapLayout layout)
+{
+	return (layout == HeightmapLayout::TILED) ? "tiled" : "row-major";
+}
+
+static const char* GetGradientName(GradientType gradientType)
+{
+	const char* names[] = { "square", "circle", "diamond", "star" };
+	return names[gradientType];
+}
+
+const std::vector<float>& ErosionBenchmark::GetNoise(int mapWidth, int mapHeight)
+{
+	std::vector<float>& noise = noises[std::make_pair(mapWidth, mapHeight)];
+	if (noise.empty())
+	{
+		noise.resize((size_t)mapWidth * mapHeight);
+		generateNoise(&noise, mapWidth, mapHeight);
+	}
+	return noise;
+}
+
+const std::vector<float>& ErosionBenchmark::GetMap(int mapWidth, int mapHeight)
+{
+	std::vector<float>& map = maps[std::make_pair(mapWidth, mapHeight)];
+	if (map.empty())
+	{
+		map.resize((size_t)mapWidth * mapHeight);
+		erosionMaker->ShapeIsland(GetNoise(mapWidth, mapHeight).data(), map.data(), nullptr, mapWidth, mapHeight, GradientType::SQUARE);
+	}
+	return map;
+}
+
+void ErosionBenchmark::AddErodeCase(int mapSize, int radius, ErosionKernel kernel, HeightmapLayout layout, int droplets)
+{
+	BenchmarkCase erode;
+	erode.name = "Erode";
+	char parameters[160];
+	snprintf(parameters, sizeof(parameters), "\"size\": %d, \"radius\": %d, \"kernel\": \"%s\", \"layout\": \"%s\"", mapSize, radius, GetKernelName(kernel), GetLayoutName(layout));
+	erode.parameters = parameters;
+	erode.itemsPerRun = droplets;
+	erode.unit = "droplets";
+	erode.setup = [this, mapSize, radius, kernel, layout]()
+	{
+		workMap = GetMap(mapSize, mapSize);
+		erosionMaker->parameters.erosionRadius = radius;
+		erosionMaker->parameters.kernel = kernel;
+		erosionMaker->parameters.layout = layout;
+		erosionMaker->SetSeed(SEED);
+		erosionMaker->Erode(&workMap, mapSize, mapSize, 0, false); // builds the brush outside of the timing
+	};
+	erode.run = [this, mapSize, droplets]()
+	{
+		erosionMaker->Erode(&workMap, mapSize, mapSize, droplets, false);
+	};
+	cases.push_back(erode);
+}
+
+void ErosionBenchmark::AddErosionMakerCases()
+{
+	const int size = BENCHMARK_MAP_SIZE;
+	const size_t cells = (size_t)size * size;
+
+	// droplets per second by map size (cache footprint), brush radius (work per step), kernel and layout
+	const int mapSizes[] = { 256, 512, 1024, 2048 };
+	for (int mapSize : mapSizes)
+	{
+		AddErodeCase(mapSize, 6, ErosionKernel::SCALAR, HeightmapLayout::ROW_MAJOR, BENCHMARK_ERODE_DROPLETS);
+	}
+	const int radii[] = { 2, 3, 4, 8 };
+	for (int radius : radii)
+	{
+		AddErodeCase(size, radius, ErosionKernel::SCALAR, HeightmapLayout::ROW_MAJOR, BENCHMARK_ERODE_DROPLETS);
+	}
+	AddErodeCase(size, 6, ErosionKernel::PACKET, HeightmapLayout::ROW_MAJOR, BENCHMARK_ERODE_DROPLETS);
+	AddErodeCase(size, 6, ErosionKernel::SCALAR, HeightmapLayout::TILED, BENCHMARK_ERODE_DROPLETS);
+	AddErodeCase(2048, 6, ErosionKernel::SCALAR, HeightmapLayout::TILED, BENCHMARK_ERODE_DROPLETS);
+
+	for (int radius : { 3, 6, 8 })
+	{
+		BenchmarkCase brush;
+		brush.name = "InitializeBrushIndices";
+		brush.parameters = "\"size\": " + std::to_string(size) + ", \"radius\": " + std::to_string(radius);
+		brush.itemsPerRun = 1;
+		brush.unit = "calls";
+		brush.setup = []() {};
+		std::shared_ptr<ErosionBrush> built = std::make_shared<ErosionBrush>(); // reused by every run, its vectors keep their capacity
+		brush.run = [built, size, radius]()
+		{
+			ErosionMaker::InitializeBrushIndices(built.get(), size, radius);
+		};
+		cases.push_back(brush);
+	}
+
+	// bilinear height and gradient at fixed pseudo random positions, in both layouts
+	for (HeightmapLayout layout : { HeightmapLayout::ROW_MAJOR, HeightmapLayout::TILED })
+	{
+		BenchmarkCase sample;
+		sample.name = "CalculateHeightAndGradient";
+		sample.parameters = "\"size\": " + std::to_string(size) + ", \"layout\": \"" + GetLayoutName(layout) + "\"";
+		sample.itemsPerRun = BENCHMARK_SAMPLES;
+		sample.unit = "samples";
+		sample.setup = [this, size, layout]()
+		{
+			if (positions.empty())
+			{
+				erosionMaker->SetSeed(SEED);
+				positions.resize(BENCHMARK_SAMPLES);
+				for (int i = 0; i < BENCHMARK_SAMPLES; i++)
+				{
+					Vector2 spawn = erosionMaker->GetDropletSpawn(i, size, size);
+					float fraction = (float)fmod(i * 0.6180339887, 1.0); // inside the cell of the spawn point
+					positions[i] = { spawn.x + fraction, spawn.y + 1.0f - fraction };
+				}
+			}
+			workMap = GetMap(size, size);
+			if (layout == HeightmapLayout::TILED)
+			{
+				TiledLayout tiles(size, size);
+				tiledMap.assign(tiles.GetSize(), 0.0f);
+				tiles.FromRowMajor(workMap.data(), tiledMap.data(), size, 0, 0, size, size);
+			}
+		};
+		sample.run = [this, size, layout]()
+		{
+			float sum = 0.0f;
+			if (layout == HeightmapLayout::TILED)
+			{
+				TiledLayout tiles(size, size);
+				for (const Vector2& position : positions)
+					sum += erosionMaker->CalculateHeightAndGradient(tiledMap.data(), tiles, position.x, position.y).gradientX;
+			}
+			else
+			{
+				RowMajorLayout rows(size);
+				for (const Vector2& position : positions)
+					sum += erosionMaker->CalculateHeightAndGradient(workMap.data(), rows, position.x, position.y).gradientX;
+			}
+			benchmarkSink = sum;
+		};
+		cases.push_back(sample);
+	}
+
+	// base heights of every noise type, and fBm on the largest maps of the application
+	const char* noiseNames[] = { "fbm", "ridged", "domain warped" }; // in NoiseType order
+	for (int mapSize : { size, 8192 })
+	{
+		for (NoiseType noiseType : { NoiseType::FBM, NoiseType::RIDGED, NoiseType::DOMAIN_WARPED })
+		{
+			if (mapSize != size && noiseType != NoiseType::FBM)
+				continue;
+			BenchmarkCase noise;
+			noise.name = "GenerateNoise";
+			noise.parameters = "\"size\": " + std::to_string(mapSize) + ", \"type\": \"" + noiseNames[noiseType] + "\"";
+			noise.itemsPerRun = (long long)mapSize * mapSize;
+			noise.unit = "cells";
+			noise.setup = [this, mapSize]()
+			{
+				workMap.resize((size_t)mapSize * mapSize);
+			};
+			noise.run = [this, mapSize, noiseType]()
+			{
+				NoiseParameters parameters;
+				parameters.type = noiseType;
+				erosionMaker->GenerateNoise(workMap.data(), mapSize, mapSize, parameters);
+			};
+			cases.push_back(noise);
+		}
+	}
+
+	for (GradientType gradientType : { GradientType::SQUARE, GradientType::CIRCLE, GradientType::DIAMOND, GradientType::STAR })
+	{
+		BenchmarkCase gradient;
+		gradient.name = "Gradient";
+		gradient.parameters = "\"size\": " + std::to_string(size) + ", \"type\": \"" + GetGradientName(gradientType) + "\"";
+		gradient.itemsPerRun = (long long)cells;
+		gradient.unit = "cells";
+		gradient.setup = [this, size]()
+		{
+			workMap = GetNoise(size, size);
+		};
+		gradient.run = [this, size, gradientType]()
+		{
+			erosionMaker->Gradient(&workMap, size, size, 0.5f, gradientType);
+		};
+		cases.push_back(gradient);
+	}
+
+	// a curve of many points and the beach curve, the table lookup costs the same. the beach curve last, the cases after
+	// it shape their islands with it
+	std::vector<Vector2> terraces;
+	for (int point = 0; point <= 32; point++)
+		terraces.push_back({ point / 32.0f, (point + 0.5f * (point % 2)) / 32.5f });
+	for (int curve = 0; curve < 2; curve++)
+	{
+		BenchmarkCase remap;
+		remap.name = "Remap";
+		remap.parameters = "\"size\": " + std::to_string(size) + ", \"curve\": \"" + (curve == 0 ? "terraces cubic" : "beach") + "\"";
+		remap.itemsPerRun = (long long)cells;
+		remap.unit = "cells";
+		remap.setup = [this, size, curve, terraces]()
+		{
+			workMap = GetNoise(size, size);
+			if (curve == 0)
+				erosionMaker->remapCurve.SetPoints(terraces, RemapInterpolation::MONOTONE_CUBIC);
+			else
+				erosionMaker->remapCurve = RemapCurve();
+		};
+		remap.run = [this, size]()
+		{
+			erosionMaker->Remap(&workMap, size, size);
+		};
+		cases.push_back(remap);
+	}
+
+	// the fused pass replacing Gradient, Remap and the upload encoding, on the map sizes of island resets
+	for (int mapSize : { size, 4096 })
+	{
+		for (GradientType gradientType : { GradientType::SQUARE, GradientType::CIRCLE, GradientType::DIAMOND, GradientType::STAR })
+		{
+			BenchmarkCase island;
+			island.name = "ShapeIsland";
+			island.parameters = "\"size\": " + std::to_string(mapSize) + ", \"type\": \"" + GetGradientName(gradientType) + "\"";
+			island.itemsPerRun = (long long)mapSize * mapSize;
+			island.unit = "cells";
+			island.setup = [this, mapSize]()
+			{
+				GetNoise(mapSize, mapSize); // generated outside of the timing
+				workMap.resize((size_t)mapSize * mapSize);
+				workValues.resize(workMap.size());
+			};
+			island.run = [this, mapSize, gradientType]()
+			{
+				erosionMaker->ShapeIsland(GetNoise(mapSize, mapSize).data(), workMap.data(), workValues.data(), mapSize, mapSize, gradientType);
+			};
+			cases.push_back(island);
+		}
+	}
+
+	// normals of the whole map at once, the texels of the terrain shader and the tree placement
+	for (int mapSize : { size, 4096 })
+	{
+		BenchmarkCase normals;
+		normals.name = "NormalMap";
+		normals.parameters = "\"size\": " + std::to_string(mapSize);
+		normals.itemsPerRun = (long long)mapSize * mapSize;
+		normals.unit = "cells";
+		normals.setup = [this, mapSize]()
+		{
+			GetMap(mapSize, mapSize); // generated outside of the timing
+			if (normalMap == nullptr || normalMap->GetWidth() != mapSize)
+				normalMap.reset(new NormalMap(mapSize, mapSize));
+		};
+		normals.run = [this, mapSize]()
+		{
+			normalMap->Calculate(GetMap(mapSize, mapSize), erosionMaker->parameters.threadCount);
+		};
+		cases.push_back(normals);
+	}
+
+	// a streamed terrain chunk of the default settings: noise, remap and erosion of the chunk and its halo, seam fade and normals
+	BenchmarkCase chunk;
+	chunk.name = "GenerateChunk";
+	chunk.parameters = "\"cells\": " + std::to_string(ChunkSettings().chunkCells);
+	chunk.itemsPerRun = 1;
+	chunk.unit = "chunks";
+	chunk.setup = []() {};
+	chunk.run = [this]()
+	{
+		TerrainChunk terrainChunk;
+		ChunkStreamer::GenerateChunk(erosionMaker, ChunkSettings(), { 3, -2 }, &terrainChunk);
+		benchmarkSink = terrainChunk.maxHeight;
+	};
+	cases.push_back(chunk);
+
+	BenchmarkCase normal;
+	normal.name = "GetNormal";
+	normal.parameters = "\"size\": " + std::to_string(size);
+	normal.itemsPerRun = (long long)cells;
+	normal.unit = "cells";
+	normal.setup = [this, size]()
+	{
+		workMap = GetMap(size, size);
+	};
+	normal.run = [this, size]()
+	{
+		float sum = 0.0f;
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+				sum += erosionMaker->GetNormal(&workMap, size, size, x, y).y;
+		}
+		benchmarkSink = sum;
+	};
+	cases.push_back(normal);
+}
+
+void ErosionBenchmark::Run(FILE* json, FILE* progress)
+{
+	// the cases change the tunables and the remap curve, they are given back at the end
+	ErosionParameters parameters = erosionMaker->parameters;
+	RemapCurve remapCurve = erosionMaker->remapCurve;
+	int threads = erosionMaker->parameters.threadCount > 0 ? erosionMaker->parameters.threadCount : ThreadPool::GetHardwareThreadCount();
+
+	fprintf(json, "{\n  \"threads\": %d,\n  \"packetInstructionSet\": \"%s\",\n  \"results\": [\n", threads, ErosionMaker::GetPacketInstructionSet());
+	for (size_t i = 0; i < cases.size(); i++)
+	{
+		const BenchmarkCase& benchmarkCase = cases[i];
+		benchmarkCase.setup(); // warm up: caches, pool threads and lazily built buffers
+		benchmarkCase.run();
+
+		std::vector<double> seconds;
+		double totalSeconds = 0.0;
+		while ((int)seconds.size() < MAX_RUNS && ((int)seconds.size() < MIN_RUNS || totalSeconds * 1000.0 < MIN_CASE_MS))
+		{
+			benchmarkCase.setup();
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			benchmarkCase.run();
+			double runSeconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count() / 1000000000.0;
+			seconds.push_back(runSeconds);
+			totalSeconds += runSeconds;
+		}
+		std::sort(seconds.begin(), seconds.end());
+		double median = seconds[seconds.size() / 2];
+		double itemsPerSecond = (median > 0.0) ? benchmarkCase.itemsPerRun / median : 0.0;
+
+		fprintf(json, "    { \"name\": \"%s\", \"parameters\": { %s }, \"runs\": %d, \"itemsPerRun\": %lld, \"unit\": \"%s\", \"medianSeconds\": %.9f, \"minSeconds\": %.9f, \"itemsPerSecond\": %.1f }%s\n",
+			benchmarkCase.name.c_str(), benchmarkCase.parameters.c_str(), (int)seconds.size(), benchmarkCase.itemsPerRun, benchmarkCase.unit, median, seconds[0], itemsPerSecond, (i + 1 < cases.size()) ? "," : "");
+		if (progress != nullptr)
+			fprintf(progress, "%-28s %-70s %14.0f %s/s\n", benchmarkCase.name.c_str(), benchmarkCase.parameters.c_str(), itemsPerSecond, benchmarkCase.unit);
+	}
+	fprintf(json, "  ]\n}\n");
+	fflush(json);
+
+	erosionMaker->parameters = parameters;
+	erosionMaker->remapCurve = remapCurve;
+}
@@ -0,0 +1,60 @@
+#ifndef EROSION_BENCHMARK
+#define EROSION_BENCHMARK
+
+#include <stdio.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ErosionMaker.h"
+#include "NormalMap.h"
+
+// fills a map of the given size with heights in range (0, 1), the same ones on every call
+typedef std::function<void(std::vector<float>* map, int mapWidth, int mapHeight)> BenchmarkMapGenerator;
+
+// a measured piece of work: setup runs untimed before every run, run is timed
+typedef struct
+{
+	std::string name;
+	std::string parameters; // members of the JSON object describing the case, e.g. "\"size\": 512"
+	long long itemsPerRun; // work units done by a run (droplets, cells, calls), gives the throughput
+	const char* unit;
+	std::function<void()> setup;
+	std::function<void()> run;
+} BenchmarkCase;
+
+// microbenchmark suite of the erosion maker hot paths: every case runs from fixed seeds and inputs, is repeated until
+// it has run long enough and reports its median time as JSON, so kernels can be compared between builds
+class ErosionBenchmark
+{
+public:
+	ErosionBenchmark(ErosionMaker* erosionMaker, BenchmarkMapGenerator generateNoise) : erosionMaker(erosionMaker), generateNoise(generateNoise) {}
+
+	void AddCase(const BenchmarkCase& benchmarkCase) { cases.push_back(benchmarkCase); } // for work that lives outside the erosion maker
+	void AddErosionMakerCases(); // Erode, brush, height and gradient, GenerateNoise, Gradient, Remap, ShapeIsland, NormalMap and GetNormal cases
+	const std::vector<float>& GetNoise(int mapWidth, int mapHeight); // heights of generateNoise for the given size, generated once
+	const std::vector<float>& GetMap(int mapWidth, int mapHeight); // island (noise, Gradient, Remap) of the given size, generated once
+	void Run(FILE* json, FILE* progress); // runs every case in order, progress (may be null) gets a line per case
+
+	static const int MIN_CASE_MS = 250; // a case is repeated until its runs add up to this
+	static const int MIN_RUNS = 3;
+	static const int MAX_RUNS = 1000;
+	static const unsigned int SEED = 1234; // droplet seed of every Erode case
+
+private:
+	ErosionMaker* erosionMaker;
+	BenchmarkMapGenerator generateNoise;
+	std::vector<BenchmarkCase> cases;
+	std::map<std::pair<int, int>, std::vector<float>> noises; // maps returned by GetNoise and GetMap, by width and height
+	std::map<std::pair<int, int>, std::vector<float>> maps;
+	std::vector<float> workMap; // map eroded by the current case
+	std::vector<float> tiledMap; // workMap in the TILED layout
+	std::vector<unsigned short> workValues; // workMap encoded for upload
+	std::unique_ptr<NormalMap> normalMap; // normals of the NormalMap cases
+	std::vector<Vector2> positions; // sample points of the height and gradient cases
+
+	void AddErodeCase(int mapSize, int radius, ErosionKernel kernel, HeightmapLayout layout, int droplets);
+};
+
+#endif
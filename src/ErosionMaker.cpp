@@ -1,349 +1,753 @@
-#include "ErosionMaker.h"
-#include <math.h>
-#include <algorithm>
-#include <iostream>
-#include <vector>
-#include <cstdlib> 
-#include <ctime> 
-#include "raymath.h"
-#include "raylib.h"
-
-void ErosionMaker::Initialize(int mapSize, bool resetSeed)
-{
-	// initialization randomizes the generator and precomputes indices and weights of erosion brush
-
-	if (resetSeed)
-	{
-		unsigned int newseed = (unsigned)time(0);
-		srand(newseed);
-		currentSeed = newseed;
-	}
-
-	if (erosionBrushIndices == nullptr || currentErosionRadius != erosionRadius || currentMapSize != mapSize)
-	{
-		InitializeBrushIndices(mapSize, erosionRadius);
-		currentErosionRadius = erosionRadius;
-		currentMapSize = mapSize;
-	}
-}
-
-// simulate erosion with the given amount of droplets
-void ErosionMaker::Erode(std::vector<float>* mapData, int mapSize, int dropletAmount, bool resetSeed)
-{
-	Initialize(mapSize, resetSeed);
-
-	for (int iteration = 0; iteration < dropletAmount; iteration++)
-	{
-		// create water droplet at random point on map (not bound to cell)
-		float posX = (rand() % (mapSize - 1)) + 0;
-		float posY = (rand() % (mapSize - 1)) + 0;
-		float dirX = 0;
-		float dirY = 0;
-		float speed = initialSpeed;
-		float water = initialWaterVolume;
-		float sediment = 0; // sediment currently carried
-
-		for (int lifetime = 0; lifetime < maxDropletLifetime; lifetime++)
-		{
-			// droplet position bound to cell
-			int nodeX = (int)posX;
-			int nodeY = (int)posY;
-			int dropletIndex = nodeY * mapSize + nodeX;
-			// calculate droplet's offset inside the cell (0,0) = at NW node, (1,1) = at SE node
-			float cellOffsetX = posX - (float)nodeX;
-			float cellOffsetY = posY - (float)nodeY;
-
-			// calculate droplet's height and direction of flow with bilinear interpolation of surrounding heights
-			HeightAndGradient heightAndGradient = CalculateHeightAndGradient(mapData, mapSize, posX, posY);
-
-			// update the droplet's direction and position (move position 1 unit regardless of speed)
-			dirX = (dirX * inertia - heightAndGradient.gradientX * (1 - inertia)); // lerp with old dir by using inertia as mix value
-			dirY = (dirY * inertia - heightAndGradient.gradientY * (1 - inertia));
-
-			// normalize direction
-			float len = sqrtf(dirX * dirX + dirY * dirY);
-			if (len > 0.0001f)
-			{
-				dirX /= len;
-				dirY /= len;
-			}
-			// update droplet position based on direction (move 1 unit)
-			posX += dirX;
-			posY += dirY;
-
-			// stop simulating droplet if it's not moving or has flowed over edge of map
-			if ((dirX == 0 && dirY == 0) || posX < 0 || posX >= mapSize - 1 || posY < 0 || posY >= mapSize - 1)
-			{
-				break;
-			}
-
-			// find the droplet's new height and calculate the deltaHeight
-			float newHeight = CalculateHeightAndGradient(mapData, mapSize, posX, posY).height;
-			float deltaHeight = newHeight - heightAndGradient.height;
-
-			// calculate the droplet's sediment capacity (higher when moving fast down a slope and contains lots of water)
-			float sedimentCapacity = std::max(-deltaHeight * speed * water * sedimentCapacityFactor, minSedimentCapacity);
-
-			// if carrying more sediment than capacity, or if flowing uphill:
-			if (sediment > sedimentCapacity || deltaHeight > 0)
-			{
-				// DEPOSIT
-
-				// if moving uphill (deltaHeight > 0) try fill up to the current height, otherwise deposit a fraction of the excess sediment
-				float amountToDeposit = (deltaHeight > 0) ? std::min(deltaHeight, sediment) : (sediment - sedimentCapacity) * depositSpeed;
-				sediment -= amountToDeposit;
-
-				// add the sediment to the four nodes of the current cell using bilinear interpolation
-				// deposition is not distributed over a radius (like erosion) so that it can fill small pits
-				(*mapData)[(size_t)dropletIndex] += amountToDeposit * (1 - cellOffsetX) * (1 - cellOffsetY);
-				(*mapData)[(size_t)dropletIndex + 1] += amountToDeposit * cellOffsetX * (1 - cellOffsetY);
-				(*mapData)[(size_t)dropletIndex + mapSize] += amountToDeposit * (1 - cellOffsetX) * cellOffsetY;
-				(*mapData)[(size_t)dropletIndex + mapSize + 1] += amountToDeposit * cellOffsetX * cellOffsetY;
-			}
-			else
-			{
-				// ERODE
-
-				// erode a fraction of the droplet's current carry capacity.
-				// clamp the erosion to the change in height so that it doesn't dig a hole in the terrain behind the droplet
-				float amountToErode = std::min((sedimentCapacity - sediment) * erodeSpeed, -deltaHeight);
-
-				// use erosion brush to erode from all nodes inside the droplet's erosion radius
-				for (int brushPointIndex = 0; brushPointIndex < (*erosionBrushIndices)[dropletIndex]->size(); brushPointIndex++)
-				{
-					int nodeIndex = (*(*erosionBrushIndices)[dropletIndex])[brushPointIndex];
-					float weighedErodeAmount = amountToErode * (*(*erosionBrushWeights)[dropletIndex])[brushPointIndex];
-					float deltaSediment = ((*mapData)[nodeIndex] < weighedErodeAmount) ? (*mapData)[nodeIndex] : weighedErodeAmount;
-					(*mapData)[nodeIndex] -= deltaSediment;
-					sediment += deltaSediment;
-				}
-			}
-
-			// update droplet's speed and water content
-			speed = sqrtf(speed * speed + deltaHeight * gravity);
-			if (isnan(speed))
-				speed = 0; // fix per alcuni NaN dovuti a speed * speed + deltaHeight * gravity negativo
-			water *= (1 - evaporateSpeed); // evaporate water
-		}
-	}
-}
-
-// applies a radial gradient to the heightmap in order to flatten the outer borders
-void ErosionMaker::Gradient(std::vector<float>* mapData, int mapSize, float normalizedOffset, GradientType gradientType)
-{
-	float radius = ((float)mapSize / 2.0f);
-	for (size_t y = 0; y < mapSize; y++)
-	{
-		for (size_t x = 0; x < mapSize; x++)
-		{
-			int index = y * mapSize + x;
-			float gradient = 0.0f;
-			switch (gradientType) {
-			case GradientType::SQUARE:
-				gradient = std::max(std::abs((float)x - radius), std::abs((float)y - radius)) / (radius); // Chebyshev distance
-				break;
-
-			case GradientType::CIRCLE:
-				gradient = std::min(((x - radius) * (x - radius) + (y - radius) * (y - radius)) / (radius * radius), 1.0f); // Euclidean distance
-				break;
-
-			case GradientType::DIAMOND:
-				gradient = std::min((std::abs((float)x - radius) + std::abs((float)y - radius)) / (radius), 1.0f); // Manhattan distance
-				break;
-
-			case GradientType::STAR:
-			{
-				float g1 = std::min((std::abs((float)x - radius) + std::abs((float)y - radius)) / (radius), 1.0f); // Manhattan distance
-				float g2 = std::max(std::abs((float)x - radius), std::abs((float)y - radius)) / (radius); // Chebyshev distance
-				gradient = Lerp(g1, g2, 0.7f); // mix manhattan and chebyshev by desired value
-			}
-				break;
-
-			default:
-				gradient = std::min(((x - radius) * (x - radius) + (y - radius) * (y - radius)) / (radius * radius), 1.0f); // Euclidean distance
-				break;
-			}
-			gradient = 1 - gradient; // invert
-			(*mapData)[index] *= gradient; // multiply height by given linear gradient
-		}
-	}
-}
-
-HeightAndGradient ErosionMaker::CalculateHeightAndGradient(std::vector<float>* mapData, int mapSize, float posX, float posY)
-{
-	int coordX = (int)posX;
-	int coordY = (int)posY;
-
-	// calculate droplet's offset inside the cell (0,0) = at NW node, (1,1) = at SE node
-	float x = posX - (float)coordX;
-	float y = posY - (float)coordY;
-
-	// calculate heights of the four nodes of the droplet's cell
-	int nodeIndexNW = coordY * mapSize + coordX;
-
-	float heightNW = (*mapData)[(size_t)nodeIndexNW];
-	float heightNE = (*mapData)[(size_t)nodeIndexNW + 1];
-	float heightSW = (*mapData)[(size_t)nodeIndexNW + mapSize];
-	float heightSE = (*mapData)[(size_t)nodeIndexNW + mapSize + 1];
-
-	// calculate droplet's direction of flow with bilinear interpolation of height difference along the edges
-	float gradientX = (heightNE - heightNW) * (1 - y) + (heightSE - heightSW) * y;
-	float gradientY = (heightSW - heightNW) * (1 - x) + (heightSE - heightNE) * x;
-
-	// calculate height with bilinear interpolation of the heights of the nodes of the cell
-	float height = heightNW * (1 - x) * (1 - y) + heightNE * x * (1 - y) + heightSW * (1 - x) * y + heightSE * x * y;
-
-	HeightAndGradient ret;
-	ret.height = height;
-	ret.gradientX = gradientX;
-	ret.gradientY = gradientY;
-	return ret;
-}
-
-void ErosionMaker::InitializeBrushIndices(int mapSize, int radius)
-{
-	erosionBrushIndices = new std::vector<std::vector<int>*>((size_t)mapSize * mapSize); // each cell stores its neighbors' indices
-	erosionBrushWeights = new std::vector<std::vector<float>*>((size_t)mapSize * mapSize); // each cell stores its neighbors' weight
-
-	std::vector<int> xOffsets((size_t)radius * radius * 4, 0);
-	std::vector<int> yOffsets((size_t)radius * radius * 4, 0);
-	std::vector<float> weights((size_t)radius * radius * 4, 0);
-	float weightSum = 0;
-	int addIndex = 0;
-
-	for (int i = 0; i < erosionBrushIndices->size(); i++) // va bene la prima coord
-	{
-		int centreX = i % mapSize; // x coordinate by cell
-		int centreY = i / mapSize; // y coodinate by cell
-
-		if (centreY <= radius || centreY >= mapSize - radius || centreX <= radius || centreX >= mapSize - radius) // loop only not too close to borders
-		{
-			weightSum = 0;
-			addIndex = 0;
-			for (int y = -radius; y <= radius; y++) // loop neighbors
-			{
-				for (int x = -radius; x <= radius; x++)
-				{
-					float sqrDst = x * x + y * y;
-					if (sqrDst < radius * radius) // take only those inside the radius of influence
-					{
-						int coordX = centreX + x;
-						int coordY = centreY + y;
-
-						if (coordX >= 0 && coordX < mapSize && coordY >= 0 && coordY < mapSize)
-						{
-							// add to brush index
-							float weight = 1 - sqrtf(sqrDst) / radius; // euclidean distance -> circle
-							weightSum += weight;
-							weights[addIndex] = weight;
-							xOffsets[addIndex] = x;
-							yOffsets[addIndex] = y;
-							addIndex++;
-						}
-					}
-				}
-			}
-		}
-
-		int numEntries = addIndex;
-		(*erosionBrushIndices)[i] = new std::vector<int>(numEntries);
-		(*erosionBrushWeights)[i] = new std::vector<float>(numEntries);
-
-		for (int j = 0; j < numEntries; j++)
-		{
-			(*(*erosionBrushIndices)[i])[j] = (yOffsets[j] + centreY) * mapSize + xOffsets[j] + centreX;
-			(*(*erosionBrushWeights)[i])[j] = weights[j] / weightSum;
-		}
-	}
-}
-
-float ErosionMaker::RemapValue(float value)
-{
-	const int points = 4;
-	// describe the remapping of the grayscale heights (beach and craters)
-	const Vector2 point[points] =
-	{
-		{0.0f,		0.0f}, // initial point (keep)
-
-		{0.15f,		0.16f}, // flatten beach
-		{0.2f,		0.16f},
-		/*{0.3f,		0.4f}, // add some craters
-		{0.4f,		0.3f},*/
-
-		{1.0f,		1.0f}, // final point (keep)
-	};
-
-	if (value < 0.0f)
-		return value;
-	for (size_t i = 1; i < points; i++)
-	{
-		if (value < point[i].x)
-			return Lerp(point[i - 1].y, point[i].y, (value - point[i - 1].x) / (point[i].x - point[i - 1].x)); // lerp based on the interval you're on
-	}
-	return value;
-}
-
-Vector3 ErosionMaker::GetNormal(std::vector<float>* mapData, int mapSize, int x, int y)
-{
-	// value from trial & error.
-	// seems to work fine for the scales we are dealing with.
-	// almost equivalent code in terrain shader to get normal
-	float strength = 20.0;
-
-	int u, v;
-
-	u = std::min(std::max(x - 1, 0), mapSize - 1);
-	v = std::min(std::max(y + 1, 0), mapSize - 1);
-	float bl = mapData->at(v * mapSize + u);
-
-	u = std::min(std::max(x, 0), mapSize - 1);
-	v = std::min(std::max(y + 1, 0), mapSize - 1);
-	float b = mapData->at(v * mapSize + u);
-
-	u = std::min(std::max(x + 1, 0), mapSize - 1);
-	v = std::min(std::max(y + 1, 0), mapSize - 1);
-	float br = mapData->at(v * mapSize + u);
-
-	u = std::min(std::max(x - 1, 0), mapSize - 1);
-	v = std::min(std::max(y, 0), mapSize - 1);
-	float l = mapData->at(v * mapSize + u);
-
-	u = std::min(std::max(x + 1, 0), mapSize - 1);
-	v = std::min(std::max(y, 0), mapSize);
-	float r = mapData->at(v * mapSize + u);
-
-	u = std::min(std::max(x - 1, 0), mapSize - 1);
-	v = std::min(std::max(y - 1, 0), mapSize - 1);
-	float tl = mapData->at(v * mapSize + u);
-
-	u = std::min(std::max(x, 0), mapSize - 1);
-	v = std::min(std::max(y - 1, 0), mapSize - 1);
-	float t = mapData->at(v * mapSize + u);
-
-	u = std::min(std::max(x + 1, 0), mapSize - 1);
-	v = std::min(std::max(y - 1, 0), mapSize - 1);
-	float tr = mapData->at(v * mapSize + u);
-
-	// compute dx using Sobel:
-	//           -1 0 1 
-	//           -2 0 2
-	//           -1 0 1
-	float dX = tr + 2.0f * r + br - tl - 2.0f * l - bl;
-
-	// compute dy using Sobel:
-	//           -1 -2 -1 
-	//            0  0  0
-	//            1  2  1
-	float dY = bl + 2.0f * b + br - tl - 2.0f * t - tr;
-
-	return Vector3Normalize({ -dX, 1.0f / strength, -dY });
-}
-
-void ErosionMaker::Remap(std::vector<float>* map, int mapSize)
-{
-
-	for (size_t i = 0; i < mapSize * mapSize; i++)
-	{
-		map->at(i) = RemapValue(map->at(i));
-	}
-}
+#include "FloatContract.h"
+#include "ErosionMaker.h"
+#include <math.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cstdlib> 
+#include <ctime> 
+#include <chrono>
+#include <climits>
+#include <map>
+#include <mutex>
+#include "raymath.h"
+#include "raylib.h"
+#include "ThreadPool.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+void ErosionMaker::Initialize(int mapWidth, bool resetSeed)
+{
+	// initialization randomizes the generator and precomputes indices and weights of erosion brush
+
+	if (resetSeed)
+	{
+		SetSeed((unsigned)time(0));
+	}
+
+	if (!brush || brush->radius != job.erosionRadius || brush->mapWidth != mapWidth)
+	{
+		brush = GetBrush(mapWidth, job.erosionRadius);
+	}
+}
+
+std::shared_ptr<const ErosionBrush> ErosionMaker::GetBrush(int mapWidth, int radius)
+{
+	// brushes are a few KB, every one built stays cached: instances eroding maps of the same width share them
+	static std::mutex cacheMutex;
+	static std::map<std::pair<int, int>, std::shared_ptr<const ErosionBrush>> cache;
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::shared_ptr<const ErosionBrush>& cached = cache[std::make_pair(mapWidth, radius)];
+	if (!cached)
+	{
+		std::shared_ptr<ErosionBrush> built = std::make_shared<ErosionBrush>();
+		InitializeBrushIndices(built.get(), mapWidth, radius);
+		cached = built;
+	}
+	return cached;
+}
+
+void ErosionMaker::SetSeed(unsigned int seed)
+{
+	currentSeed = seed;
+	dropletCounter = 0;
+}
+
+// SplitMix64 finalizer, a cheap bijective mix of all 64 bits
+static unsigned long long MixBits(unsigned long long value)
+{
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+// index of the lowest set bit of a non-zero value
+static int CountTrailingZeros(unsigned long long value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (int)index;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+// spawn point of a droplet is a pure function of (seed, droplet index), so any droplet can be recomputed on its own
+Vector2 ErosionMaker::GetDropletSpawn(unsigned long long dropletIndex, int mapWidth, int mapHeight)
+{
+	unsigned long long bits = MixBits(MixBits(currentSeed) + dropletIndex);
+	// map each 32-bit half to [0, size - 1) with a multiply instead of a modulo
+	int x = (int)(((bits & 0xFFFFFFFFull) * (unsigned long long)(mapWidth - 1)) >> 32);
+	int y = (int)(((bits >> 32) * (unsigned long long)(mapHeight - 1)) >> 32);
+	return { (float)x, (float)y };
+}
+
+// simulate erosion with the given amount of droplets
+void ErosionMaker::Erode(std::vector<float>* mapData, int mapWidth, int mapHeight, int dropletAmount, bool resetSeed)
+{
+	job = parameters;
+	ErodeJob(mapData, mapWidth, mapHeight, dropletAmount, resetSeed);
+}
+
+void ErosionMaker::ErodeJob(std::vector<float>* mapData, int mapWidth, int mapHeight, int dropletAmount, bool resetSeed)
+{
+	Initialize(mapWidth, resetSeed);
+
+	if (job.model == ErosionModel::PIPES)
+	{
+		if (resetSeed)
+			ResetPipeState();
+		ErodePipes(mapData, mapWidth, mapHeight, dropletAmount);
+		if (dropletAmount > 0)
+			MarkAllDirty(mapWidth, mapHeight); // every cell with water can change
+		return;
+	}
+
+	// no droplets (a negative count included) leaves the map as it is, the dirty tiles still follow the map size
+	if (dropletAmount <= 0)
+	{
+		PrepareDirtyTiles(mapWidth, mapHeight);
+		return;
+	}
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	// droplets are only independent when they can't reach each other's cells, so the map is split in tiles at least one reach wide.
+	// tiles are colored in a 3x3 pattern: two tiles of the same color are always separated by two other tiles,
+	// so droplets spawned in same colored tiles never touch the same cell and each color can run in parallel
+	int reach = GetDropletReach();
+	int tileColumns = std::max(1, (mapWidth - 1) / reach);
+	int tileRows = std::max(1, (mapHeight - 1) / reach);
+	int threads = (job.threadCount <= 0) ? ThreadPool::GetHardwareThreadCount() : job.threadCount;
+
+	// droplets use consecutive indices of the seed's sequence across calls
+	unsigned long long firstDroplet = dropletCounter;
+	dropletCounter += (unsigned long long)dropletAmount;
+
+	// the schedule only depends on map size and reach, never on the thread count:
+	// the same seed and batches produce the same heightmap whether one or many threads run the tiles
+
+	// sort droplets by the tile they spawn in, keeping their order inside a tile
+	std::vector<int> spawnTiles((size_t)dropletAmount);
+	std::vector<Vector2> spawns((size_t)dropletAmount);
+	std::vector<int> tileStart((size_t)tileColumns * tileRows + 1, 0);
+	for (int iteration = 0; iteration < dropletAmount; iteration++)
+	{
+		// create water droplet at random point on map (not bound to cell)
+		Vector2 spawn = GetDropletSpawn(firstDroplet + iteration, mapWidth, mapHeight);
+		long long x = (long long)spawn.x;
+		long long y = (long long)spawn.y;
+		int tile = (int)(y * tileRows / (mapHeight - 1)) * tileColumns + (int)(x * tileColumns / (mapWidth - 1));
+		spawns[iteration] = spawn;
+		spawnTiles[iteration] = tile;
+		tileStart[(size_t)tile + 1]++;
+	}
+	for (size_t i = 1; i < tileStart.size(); i++)
+	{
+		tileStart[i] += tileStart[i - 1];
+	}
+	std::vector<Vector2> sortedSpawns((size_t)dropletAmount);
+	std::vector<int> tileFill(tileStart.begin(), tileStart.end() - 1);
+	for (int iteration = 0; iteration < dropletAmount; iteration++)
+	{
+		sortedSpawns[tileFill[spawnTiles[iteration]]++] = spawns[iteration];
+	}
+
+	// every pool thread marks the cells it writes in its own dirty mask
+	PrepareDirtyTiles(mapWidth, mapHeight);
+	workerDirtyTiles.resize((size_t)ThreadPool::GetInstance().GetThreadCount());
+	for (size_t worker = 0; worker < workerDirtyTiles.size(); worker++)
+	{
+		workerDirtyTiles[worker].assign(dirtyTiles.size(), 0);
+	}
+	DROPLET_STATISTICS(workerStatistics.assign(workerDirtyTiles.size(), DropletStatistics()));
+
+	bool tiled = UsesTiledMap();
+	TiledLayout tiledCells(mapWidth, mapHeight);
+	if (tiled)
+	{
+		tiledMap.resize(tiledCells.GetSize());
+		ThreadPool::GetInstance().ParallelForRows(tiledCells.blockRows, 4, threads, [&](int firstRow, int lastRow)
+		{
+			tiledCells.FromRowMajor(mapData->data(), tiledMap.data(), mapWidth, 0, firstRow * TiledLayout::BLOCK_SIZE, mapWidth, std::min(lastRow * TiledLayout::BLOCK_SIZE, mapHeight));
+		});
+	}
+
+	// run the 9 colors one after the other, tiles of the same color concurrently
+	// (maps smaller than 3 tiles per axis simply get a single tile per color)
+	std::vector<int> phaseTiles;
+	for (int phase = 0; phase < 9; phase++)
+	{
+		phaseTiles.clear();
+		for (int tileY = phase / 3; tileY < tileRows; tileY += 3)
+		{
+			for (int tileX = phase % 3; tileX < tileColumns; tileX += 3)
+			{
+				int tile = tileY * tileColumns + tileX;
+				if (tileStart[tile + 1] > tileStart[tile])
+					phaseTiles.push_back(tile);
+			}
+		}
+
+		ThreadPool::GetInstance().ParallelFor((int)phaseTiles.size(), threads, [&](int index, int worker)
+		{
+			int tile = phaseTiles[index];
+			SimulateDroplets(mapData, mapWidth, mapHeight, &sortedSpawns[tileStart[tile]], tileStart[(size_t)tile + 1] - tileStart[tile], workerDirtyTiles[worker].data(), workerStatistics.empty() ? nullptr : &workerStatistics[worker]);
+		});
+	}
+	for (size_t worker = 1; worker < workerDirtyTiles.size(); worker++)
+	{
+		for (size_t word = 0; word < dirtyTiles.size(); word++)
+		{
+			workerDirtyTiles[0][word] |= workerDirtyTiles[worker][word];
+		}
+	}
+	DROPLET_STATISTICS(for (const DropletStatistics& statistics : workerStatistics) AddDropletStatistics(&dropletStatistics, statistics));
+	int dirtyColumns = GetDirtyTileCount(mapWidth);
+	for (size_t word = 0; word < dirtyTiles.size(); word++)
+	{
+		unsigned long long changed = workerDirtyTiles[0][word];
+		dirtyTiles[word] |= changed;
+		for (; tiled && changed != 0; changed &= changed - 1)
+		{
+			// only the tiles written by this call go back to the map, dirty tiles are a whole number of blocks
+			int tile = (int)(word * 64) + CountTrailingZeros(changed);
+			int x = (tile % dirtyColumns) * DIRTY_TILE_SIZE;
+			int y = (tile / dirtyColumns) * DIRTY_TILE_SIZE;
+			tiledCells.ToRowMajor(tiledMap.data(), mapData->data(), mapWidth, x, y, std::min(x + DIRTY_TILE_SIZE, mapWidth), std::min(y + DIRTY_TILE_SIZE, mapHeight));
+		}
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000000.0;
+	if (seconds > 0.0)
+		dropletsPerSecond = (float)(dropletAmount / seconds);
+}
+
+void ErosionMaker::StartErode(long long numIterations)
+{
+	incrementalRequested = std::max(numIterations, 0ll);
+	incrementalDone = 0;
+	incrementalCancelled = false;
+	incrementalFinished = false;
+	incrementalParameters = parameters;
+}
+
+void ErosionMaker::CancelErode()
+{
+	cancelRequested = true;
+}
+
+void ErosionMaker::ClearCancel()
+{
+	cancelRequested = false;
+}
+
+ErosionProgress ErosionMaker::GetErodeProgress()
+{
+	return { incrementalRequested.load(), incrementalDone.load(), incrementalFinished.load(), incrementalCancelled.load() };
+}
+
+ErosionProgress ErosionMaker::ContinueErode(std::vector<float>* mapData, int mapWidth, int mapHeight, float budgetSeconds)
+{
+	// the started erosion is split in batches sized from the measured cost of an iteration, so a call ends close to its budget.
+	// a batch aims at a quarter of the budget: a wrong estimate (first batches, map changes) overshoots by a fraction of it
+	// and the new measure corrects the next batches. the result depends on how the iterations are split, like calling Erode
+	// with smaller amounts does. batches are also kept short so CancelErode is noticed quickly whatever the budget
+	const int firstBatch[2] = { 64, 1 }; // iterations probed when the cost of the model is unknown
+	const double maxBatchSeconds = 0.02;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	job = incrementalParameters; // the whole erosion runs with the parameters it started with
+	double& cost = secondsPerIteration[job.model == ErosionModel::PIPES ? 1 : 0];
+	long long doneInCall = 0;
+
+	while (!incrementalFinished)
+	{
+		if (cancelRequested)
+		{
+			incrementalCancelled = true;
+			incrementalFinished = true;
+			break;
+		}
+		long long requested = incrementalRequested;
+		long long remaining = (requested > 0) ? requested - incrementalDone : (long long)INT_MAX;
+		if (remaining <= 0)
+		{
+			incrementalFinished = true;
+			break;
+		}
+		double left = budgetSeconds - std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count() / 1000000000.0;
+		if (doneInCall > 0 && (left <= 0.0 || cost > left))
+			break; // the next iteration wouldn't fit, a call always does at least one
+
+		long long batch = (cost > 0.0) ? (long long)(std::min(std::min(left, budgetSeconds * 0.25), maxBatchSeconds) / cost) : firstBatch[job.model == ErosionModel::PIPES ? 1 : 0];
+		batch = std::min(std::max(batch, 1ll), std::min(remaining, (long long)INT_MAX));
+
+		std::chrono::steady_clock::time_point batchBegin = std::chrono::steady_clock::now();
+		ErodeJob(mapData, mapWidth, mapHeight, (int)batch, false);
+		double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - batchBegin).count() / 1000000000.0;
+		double batchCost = seconds / batch;
+		cost = (cost > 0.0) ? cost * 0.7 + batchCost * 0.3 : batchCost; // smoothed, a single slow batch (page faults, preemption) doesn't halve the next ones
+
+		incrementalDone += batch;
+		doneInCall += batch;
+	}
+	return GetErodeProgress();
+}
+
+void ErosionMaker::PrepareDirtyTiles(int mapWidth, int mapHeight)
+{
+	if (dirtyMapWidth != mapWidth || dirtyMapHeight != mapHeight)
+	{
+		size_t tiles = (size_t)GetDirtyTileCount(mapWidth) * GetDirtyTileCount(mapHeight);
+		dirtyTiles.assign((tiles + 63) / 64, 0);
+		dirtyMapWidth = mapWidth;
+		dirtyMapHeight = mapHeight;
+	}
+}
+
+void ErosionMaker::MarkAllDirty(int mapWidth, int mapHeight)
+{
+	PrepareDirtyTiles(mapWidth, mapHeight);
+	size_t tiles = (size_t)GetDirtyTileCount(mapWidth) * GetDirtyTileCount(mapHeight);
+	for (size_t tile = 0; tile < tiles; tile++)
+	{
+		dirtyTiles[tile >> 6] |= 1ull << (tile & 63);
+	}
+}
+
+void ErosionMaker::TakeDirtyTiles(std::vector<unsigned long long>* tiles, int mapWidth, int mapHeight)
+{
+	PrepareDirtyTiles(mapWidth, mapHeight);
+	tiles->assign(dirtyTiles.begin(), dirtyTiles.end());
+	std::fill(dirtyTiles.begin(), dirtyTiles.end(), 0);
+}
+
+// max distance from the spawn point of a droplet that can be touched during its lifetime
+int ErosionMaker::GetDropletReach()
+{
+	// a droplet moves at most 1 cell per step, erodes cells inside erosionRadius and reads/deposits on the next node of its cell
+	return job.maxDropletLifetime + job.erosionRadius + 2;
+}
+
+// runs the given droplets in order with the selected kernel
+void ErosionMaker::SimulateDroplets(std::vector<float>* mapData, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics)
+{
+	if (job.kernel == ErosionKernel::PACKET)
+	{
+		SimulateDropletPackets(mapData, mapWidth, mapHeight, spawns, count, dirty, statistics);
+		return;
+	}
+
+	if (UsesTiledMap())
+	{
+		TiledLayout cells(mapWidth, mapHeight);
+		for (int i = 0; i < count; i++)
+		{
+			SimulateDropletIn(tiledMap.data(), cells, mapWidth, mapHeight, spawns[i].x, spawns[i].y, dirty, statistics);
+		}
+		return;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		SimulateDroplet(mapData, mapWidth, mapHeight, spawns[i].x, spawns[i].y, dirty, statistics);
+	}
+}
+
+void ErosionMaker::SimulateDroplet(std::vector<float>* mapData, int mapWidth, int mapHeight, float posX, float posY, unsigned long long* dirty, DropletStatistics* statistics)
+{
+	SimulateDropletIn(mapData->data(), RowMajorLayout(mapWidth), mapWidth, mapHeight, posX, posY, dirty, statistics);
+}
+
+// the droplet kernel, cells holds the storage order of heights
+template <class Layout>
+void ErosionMaker::SimulateDropletIn(float* heights, const Layout& cells, int mapWidth, int mapHeight, float posX, float posY, unsigned long long* dirty, DropletStatistics* statistics)
+{
+	float dirX = 0;
+	float dirY = 0;
+	float speed = job.initialSpeed;
+	float water = job.initialWaterVolume;
+	float sediment = 0; // sediment currently carried
+	// statistics are kept in locals while the droplet runs, the steps that didn't deposit eroded
+	DROPLET_STATISTICS(int depositSteps = 0; int nanSpeeds = 0; float deposited = 0.0f);
+
+	int lifetime;
+	for (lifetime = 0; lifetime < job.maxDropletLifetime; lifetime++)
+	{
+		// droplet position bound to cell
+		int nodeX = (int)posX;
+		int nodeY = (int)posY;
+		// calculate droplet's offset inside the cell (0,0) = at NW node, (1,1) = at SE node
+		float cellOffsetX = posX - (float)nodeX;
+		float cellOffsetY = posY - (float)nodeY;
+
+		// calculate droplet's height and direction of flow with bilinear interpolation of surrounding heights
+		HeightAndGradient heightAndGradient = CalculateHeightAndGradient(heights, cells, posX, posY);
+
+		// update the droplet's direction and position (move position 1 unit regardless of speed)
+		dirX = (dirX * job.inertia - heightAndGradient.gradientX * (1 - job.inertia)); // lerp with old dir by using inertia as mix value
+		dirY = (dirY * job.inertia - heightAndGradient.gradientY * (1 - job.inertia));
+
+		// normalize direction
+		float len = sqrtf(dirX * dirX + dirY * dirY);
+		if (len > 0.0001f)
+		{
+			dirX /= len;
+			dirY /= len;
+		}
+		// update droplet position based on direction (move 1 unit)
+		posX += dirX;
+		posY += dirY;
+
+		// stop simulating droplet if it's not moving or has flowed over edge of map
+		if ((dirX == 0 && dirY == 0) || posX < 0 || posX >= mapWidth - 1 || posY < 0 || posY >= mapHeight - 1)
+		{
+			break;
+		}
+
+		// find the droplet's new height and calculate the deltaHeight
+		float newHeight = CalculateHeightAndGradient(heights, cells, posX, posY).height;
+		float deltaHeight = newHeight - heightAndGradient.height;
+
+		// calculate the droplet's sediment capacity (higher when moving fast down a slope and contains lots of water)
+		float sedimentCapacity = std::max(-deltaHeight * speed * water * job.sedimentCapacityFactor, job.minSedimentCapacity);
+		MarkDirtyNode(dirty, mapWidth, mapHeight, nodeX, nodeY); // the droplet deposits or erodes around its node
+
+		// if carrying more sediment than capacity, or if flowing uphill:
+		if (sediment > sedimentCapacity || deltaHeight > 0)
+		{
+			// DEPOSIT
+
+			// if moving uphill (deltaHeight > 0) try fill up to the current height, otherwise deposit a fraction of the excess sediment
+			float amountToDeposit = (deltaHeight > 0) ? std::min(deltaHeight, sediment) : (sediment - sedimentCapacity) * job.depositSpeed;
+			sediment -= amountToDeposit;
+			DROPLET_STATISTICS(depositSteps++; deposited += amountToDeposit);
+
+			// add the sediment to the four nodes of the current cell using bilinear interpolation
+			// deposition is not distributed over a radius (like erosion) so that it can fill small pits
+			heights[cells.Index(nodeX, nodeY)] += amountToDeposit * (1 - cellOffsetX) * (1 - cellOffsetY);
+			heights[cells.Index(nodeX + 1, nodeY)] += amountToDeposit * cellOffsetX * (1 - cellOffsetY);
+			heights[cells.Index(nodeX, nodeY + 1)] += amountToDeposit * (1 - cellOffsetX) * cellOffsetY;
+			heights[cells.Index(nodeX + 1, nodeY + 1)] += amountToDeposit * cellOffsetX * cellOffsetY;
+		}
+		else
+		{
+			// ERODE
+
+			// erode a fraction of the droplet's current carry capacity.
+			// clamp the erosion to the change in height so that it doesn't dig a hole in the terrain behind the droplet
+			float amountToErode = std::min((sedimentCapacity - sediment) * job.erodeSpeed, -deltaHeight);
+
+			// use erosion brush to erode from all nodes inside the droplet's erosion radius
+			ErodeWithBrush(heights, cells, mapWidth, mapHeight, nodeX, nodeY, amountToErode, sediment);
+		}
+
+		// update droplet's speed and water content
+		speed = sqrtf(speed * speed + deltaHeight * job.gravity);
+		if (isnan(speed))
+		{
+			speed = 0; // fix per alcuni NaN dovuti a speed * speed + deltaHeight * gravity negativo
+			DROPLET_STATISTICS(nanSpeeds++);
+		}
+		water *= (1 - job.evaporateSpeed); // evaporate water
+	}
+
+#if EROSION_STATISTICS
+	if (statistics != nullptr)
+	{
+		// the droplet eroded what it deposited and what it still carries
+		RecordDroplet(statistics, lifetime, (lifetime == job.maxDropletLifetime) ? DropletEnd::LIFETIME : ((dirX == 0 && dirY == 0) ? DropletEnd::STALLED : DropletEnd::EDGE));
+		statistics->erodeSteps += lifetime - depositSteps;
+		statistics->depositSteps += depositSteps;
+		statistics->nanSpeeds += nanSpeeds;
+		statistics->eroded += (double)deposited + sediment;
+		statistics->deposited += deposited;
+	}
+#endif
+}
+
+void ErosionMaker::AddDropletStatistics(DropletStatistics* total, const DropletStatistics& statistics)
+{
+	if (total->lifetimes.size() < statistics.lifetimes.size())
+		total->lifetimes.resize(statistics.lifetimes.size(), 0);
+	for (size_t steps = 0; steps < statistics.lifetimes.size(); steps++)
+	{
+		total->lifetimes[steps] += statistics.lifetimes[steps];
+	}
+	total->droplets += statistics.droplets;
+	for (int end = 0; end < 3; end++)
+	{
+		total->ends[end] += statistics.ends[end];
+	}
+	total->erodeSteps += statistics.erodeSteps;
+	total->depositSteps += statistics.depositSteps;
+	total->nanSpeeds += statistics.nanSpeeds;
+	total->eroded += statistics.eroded;
+	total->deposited += statistics.deposited;
+}
+
+// applies a radial gradient to the heightmap in order to flatten the outer borders
+void ErosionMaker::Gradient(std::vector<float>* mapData, int mapWidth, int mapHeight, float normalizedOffset, GradientType gradientType)
+{
+	// distances are measured in units of the horizontal radius, rows are stretched so the shape fills rectangular maps
+	float radius = ((float)mapWidth / 2.0f);
+	float radiusY = ((float)mapHeight / 2.0f);
+	float stretchY = radius / radiusY;
+	for (int row = 0; row < mapHeight; row++)
+	{
+		float y = radius + ((float)row - radiusY) * stretchY;
+		for (int column = 0; column < mapWidth; column++)
+		{
+			float x = (float)column;
+			size_t index = (size_t)row * mapWidth + column;
+			float gradient = 0.0f;
+			switch (gradientType) {
+			case GradientType::SQUARE:
+				gradient = std::max(std::abs((float)x - radius), std::abs((float)y - radius)) / (radius); // Chebyshev distance
+				break;
+
+			case GradientType::CIRCLE:
+				gradient = std::min(((x - radius) * (x - radius) + (y - radius) * (y - radius)) / (radius * radius), 1.0f); // Euclidean distance
+				break;
+
+			case GradientType::DIAMOND:
+				gradient = std::min((std::abs((float)x - radius) + std::abs((float)y - radius)) / (radius), 1.0f); // Manhattan distance
+				break;
+
+			case GradientType::STAR:
+			{
+				float g1 = std::min((std::abs((float)x - radius) + std::abs((float)y - radius)) / (radius), 1.0f); // Manhattan distance
+				float g2 = std::max(std::abs((float)x - radius), std::abs((float)y - radius)) / (radius); // Chebyshev distance
+				gradient = Lerp(g1, g2, 0.7f); // mix manhattan and chebyshev by desired value
+			}
+				break;
+
+			default:
+				gradient = std::min(((x - radius) * (x - radius) + (y - radius) * (y - radius)) / (radius * radius), 1.0f); // Euclidean distance
+				break;
+			}
+			gradient = 1 - gradient; // invert
+			(*mapData)[index] *= gradient; // multiply height by given linear gradient
+		}
+	}
+}
+
+template <class Layout>
+HeightAndGradient ErosionMaker::CalculateHeightAndGradient(const float* heights, const Layout& cells, float posX, float posY)
+{
+	int coordX = (int)posX;
+	int coordY = (int)posY;
+
+	// calculate droplet's offset inside the cell (0,0) = at NW node, (1,1) = at SE node
+	float x = posX - (float)coordX;
+	float y = posY - (float)coordY;
+
+	// calculate heights of the four nodes of the droplet's cell
+	float heightNW = heights[cells.Index(coordX, coordY)];
+	float heightNE = heights[cells.Index(coordX + 1, coordY)];
+	float heightSW = heights[cells.Index(coordX, coordY + 1)];
+	float heightSE = heights[cells.Index(coordX + 1, coordY + 1)];
+
+	// calculate droplet's direction of flow with bilinear interpolation of height difference along the edges
+	float gradientX = (heightNE - heightNW) * (1 - y) + (heightSE - heightSW) * y;
+	float gradientY = (heightSW - heightNW) * (1 - x) + (heightSE - heightNE) * x;
+
+	// calculate height with bilinear interpolation of the heights of the nodes of the cell
+	float height = heightNW * (1 - x) * (1 - y) + heightNE * x * (1 - y) + heightSW * (1 - x) * y + heightSE * x * y;
+
+	HeightAndGradient ret;
+	ret.height = height;
+	ret.gradientX = gradientX;
+	ret.gradientY = gradientY;
+	return ret;
+}
+
+// out of line copies for ErosionBenchmark, the kernels inline them
+template HeightAndGradient ErosionMaker::CalculateHeightAndGradient(const float* heights, const RowMajorLayout& cells, float posX, float posY);
+template HeightAndGradient ErosionMaker::CalculateHeightAndGradient(const float* heights, const TiledLayout& cells, float posX, float posY);
+
+void ErosionMaker::InitializeBrushIndices(ErosionBrush* brush, int mapWidth, int radius)
+{
+	// a single stencil is enough for every cell: memory is O(radius^2) instead of O(mapWidth * mapHeight * radius^2)
+	brush->radius = radius;
+	brush->mapWidth = mapWidth;
+	brush->offsetsX.clear();
+	brush->offsetsY.clear();
+	brush->indexOffsets.clear();
+	brush->rawWeights.clear();
+	brush->weights.clear();
+
+	float weightSum = 0;
+	for (int y = -radius; y <= radius; y++) // loop neighbors
+	{
+		for (int x = -radius; x <= radius; x++)
+		{
+			float sqrDst = x * x + y * y;
+			if (sqrDst < radius * radius) // take only those inside the radius of influence
+			{
+				float weight = 1 - sqrtf(sqrDst) / radius; // euclidean distance -> circle
+				weightSum += weight;
+				brush->offsetsX.push_back(x);
+				brush->offsetsY.push_back(y);
+				brush->indexOffsets.push_back(y * mapWidth + x);
+				brush->rawWeights.push_back(weight);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < brush->rawWeights.size(); i++)
+	{
+		brush->weights.push_back(brush->rawWeights[i] / weightSum);
+	}
+
+	// points are sorted by row and contiguous inside a row, group them in horizontal runs
+	brush->rows.clear();
+	for (size_t i = 0; i < brush->offsetsX.size(); i++)
+	{
+		if (i == 0 || brush->offsetsY[i] != brush->offsetsY[i - 1])
+			brush->rows.push_back({ brush->offsetsY[i] * mapWidth + brush->offsetsX[i], (int)i, 0 });
+		brush->rows.back().count++;
+	}
+}
+
+void ErosionMaker::ErodeWithBrush(float* heights, const RowMajorLayout& cells, int mapWidth, int mapHeight, int nodeX, int nodeY, float amountToErode, float& sediment)
+{
+	if (nodeX >= brush->radius && nodeX < mapWidth - brush->radius && nodeY >= brush->radius && nodeY < mapHeight - brush->radius)
+	{
+		// the whole brush is inside the map
+		float* center = heights + cells.Index(nodeX, nodeY);
+		const int* indexOffsets = brush->indexOffsets.data();
+		const float* weights = brush->weights.data();
+		size_t brushSize = brush->indexOffsets.size();
+		for (size_t brushPointIndex = 0; brushPointIndex < brushSize; brushPointIndex++)
+		{
+			float* node = center + indexOffsets[brushPointIndex];
+			float weighedErodeAmount = amountToErode * weights[brushPointIndex];
+			float deltaSediment = (*node < weighedErodeAmount) ? *node : weighedErodeAmount;
+			*node -= deltaSediment;
+			sediment += deltaSediment;
+		}
+		return;
+	}
+	ErodeWithClippedBrush(heights, cells, mapWidth, mapHeight, nodeX, nodeY, amountToErode, sediment);
+}
+
+void ErosionMaker::ErodeWithBrush(float* heights, const TiledLayout& cells, int mapWidth, int mapHeight, int nodeX, int nodeY, float amountToErode, float& sediment)
+{
+	if (nodeX >= brush->radius && nodeX < mapWidth - brush->radius && nodeY >= brush->radius && nodeY < mapHeight - brush->radius)
+	{
+		// the whole brush is inside the map, same points in the same order as rows (same result).
+		// along a run the Morton code of x is incremented in place and the block changes every BLOCK_SIZE cells
+		const int xBits = 0x55; // bits of x in the Morton code of a cell inside its block
+		const float* weights = brush->weights.data();
+		for (const BrushRow& row : brush->rows)
+		{
+			int x = nodeX + brush->offsetsX[row.firstPoint];
+			int y = nodeY + brush->offsetsY[row.firstPoint];
+			float* rowBlocks = heights + cells.Index(0, y); // first block of the block row, y bits of the code included
+			size_t block = (size_t)(x >> TiledLayout::BLOCK_BITS) * TiledLayout::BLOCK_CELLS;
+			int code = TiledLayout::Spread(x & (TiledLayout::BLOCK_SIZE - 1));
+			for (int point = row.firstPoint; point < row.firstPoint + row.count; point++)
+			{
+				float* node = rowBlocks + block + code;
+				float weighedErodeAmount = amountToErode * weights[point];
+				float deltaSediment = (*node < weighedErodeAmount) ? *node : weighedErodeAmount;
+				*node -= deltaSediment;
+				sediment += deltaSediment;
+				code = (code - xBits) & xBits; // x + 1 on the x bits only
+				if (code == 0)
+					block += TiledLayout::BLOCK_CELLS;
+			}
+		}
+		return;
+	}
+	ErodeWithClippedBrush(heights, cells, mapWidth, mapHeight, nodeX, nodeY, amountToErode, sediment);
+}
+
+// border band: drop the brush points outside the map and renormalize the weights of the others
+template <class Layout>
+void ErosionMaker::ErodeWithClippedBrush(float* heights, const Layout& cells, int mapWidth, int mapHeight, int nodeX, int nodeY, float amountToErode, float& sediment)
+{
+	float weightSum = 0;
+	for (size_t brushPointIndex = 0; brushPointIndex < brush->rawWeights.size(); brushPointIndex++)
+	{
+		int coordX = nodeX + brush->offsetsX[brushPointIndex];
+		int coordY = nodeY + brush->offsetsY[brushPointIndex];
+		if (coordX >= 0 && coordX < mapWidth && coordY >= 0 && coordY < mapHeight)
+			weightSum += brush->rawWeights[brushPointIndex];
+	}
+	for (size_t brushPointIndex = 0; brushPointIndex < brush->rawWeights.size(); brushPointIndex++)
+	{
+		int coordX = nodeX + brush->offsetsX[brushPointIndex];
+		int coordY = nodeY + brush->offsetsY[brushPointIndex];
+		if (coordX >= 0 && coordX < mapWidth && coordY >= 0 && coordY < mapHeight)
+		{
+			float& node = heights[cells.Index(coordX, coordY)];
+			float weighedErodeAmount = amountToErode * (brush->rawWeights[brushPointIndex] / weightSum);
+			float deltaSediment = (node < weighedErodeAmount) ? node : weighedErodeAmount;
+			node -= deltaSediment;
+			sediment += deltaSediment;
+		}
+	}
+}
+
+Vector3 ErosionMaker::GetNormal(std::vector<float>* mapData, int mapWidth, int mapHeight, int x, int y)
+{
+	return CalculateNormal(mapData->data(), RowMajorLayout(mapWidth), mapWidth, mapHeight, x, y);
+}
+
+template <class Layout>
+Vector3 ErosionMaker::CalculateNormal(const float* heights, const Layout& cells, int mapWidth, int mapHeight, int x, int y)
+{
+	// value from trial & error.
+	// seems to work fine for the scales we are dealing with.
+	// almost equivalent code in terrain shader to get normal
+	// (tuned on 512 cells wide maps: finer maps have smaller height steps between cells for the same slope)
+	float strength = 20.0f * mapWidth / 512.0f;
+
+	int left = std::min(std::max(x - 1, 0), mapWidth - 1);
+	int center = std::min(std::max(x, 0), mapWidth - 1);
+	int right = std::min(std::max(x + 1, 0), mapWidth - 1);
+	int top = std::min(std::max(y - 1, 0), mapHeight - 1);
+	int middle = std::min(std::max(y, 0), mapHeight - 1);
+	int bottom = std::min(std::max(y + 1, 0), mapHeight - 1);
+
+	float bl = heights[cells.Index(left, bottom)];
+	float b = heights[cells.Index(center, bottom)];
+	float br = heights[cells.Index(right, bottom)];
+	float l = heights[cells.Index(left, middle)];
+	float r = heights[cells.Index(right, middle)];
+	float tl = heights[cells.Index(left, top)];
+	float t = heights[cells.Index(center, top)];
+	float tr = heights[cells.Index(right, top)];
+
+	// compute dx using Sobel:
+	//           -1 0 1 
+	//           -2 0 2
+	//           -1 0 1
+	float dX = tr + 2.0f * r + br - tl - 2.0f * l - bl;
+
+	// compute dy using Sobel:
+	//           -1 -2 -1 
+	//            0  0  0
+	//            1  2  1
+	float dY = bl + 2.0f * b + br - tl - 2.0f * t - tr;
+
+	return Vector3Normalize({ -dX, 1.0f / strength, -dY });
+}
+
+static const int REMAP_ROWS_PER_TASK = 16; // rows of the map remapped by a single task
+
+void ErosionMaker::Remap(std::vector<float>* map, int mapWidth, int mapHeight)
+{
+	int threads = (parameters.threadCount <= 0) ? ThreadPool::GetHardwareThreadCount() : parameters.threadCount;
+	float* heights = map->data();
+	ThreadPool::GetInstance().ParallelForRows(mapHeight, REMAP_ROWS_PER_TASK, threads, [&](int firstRow, int lastRow)
+	{
+		remapCurve.Apply(heights + (size_t)firstRow * mapWidth, (lastRow - firstRow) * mapWidth);
+	});
+}
@@ -1,97 +1,350 @@
-#ifndef EROSION_MAKER
-#define EROSION_MAKER
-
-#include <iostream>
-#include <vector>
-#include "raylib.h"
-
-// used to sample a point in the heightmap and get the gradient
-typedef struct
-{
-	float height;
-	float gradientX;
-	float gradientY;
-} HeightAndGradient;
-
-// describes the shape of the smoothing to apply to map borders
-enum GradientType
-{
-	SQUARE = 0,
-	CIRCLE = 1,
-	DIAMOND = 2,
-	STAR = 3,
-};
-
-// singleton responsible for simulating erosion on a heightmap
-class ErosionMaker
-{
-public:
-	static ErosionMaker& GetInstance()
-	{
-		static ErosionMaker instance; // Guaranteed to be destroyed.
-									  // Instantiated on first use.
-		return instance;
-	}
-
-private:
-	ErosionMaker() {} // Constructor? (the {} brackets) are needed here.
-
-	// C++ 03
-	// ========
-	// Don't forget to declare these two. You want to make sure they
-	// are inaccessible(especially from outside), otherwise, you may accidentally get copies of
-	// your singleton appearing.
-	ErosionMaker(ErosionMaker const&);   // Don't Implement
-	void operator=(ErosionMaker const&); // Don't Implement
-
-	// C++ 11
-	// =======
-	// We can use the better technique of deleting the methods
-	// we don't want.
-
-	// indices and weights of erosion brush precomputed for every cell
-	// it's a cache used to speed up the area of effect erosion of a droplet
-	std::vector<std::vector<int>*>* erosionBrushIndices = nullptr; // for each cell, a reference to neighbors is held
-	std::vector<std::vector<float>*>* erosionBrushWeights = nullptr; // for each cell, a reference to how much it influences neighbors
-
-	int currentSeed; // current random seed
-	int currentErosionRadius; 
-	int currentMapSize;
-
-	void Initialize(int mapSize, bool resetSeed); 
-	HeightAndGradient CalculateHeightAndGradient(std::vector<float>* nodes, int mapSize, float posX, float posY); // calculates height and gradient of a spot in the map
-	void InitializeBrushIndices(int mapSize, int radius); // initialize the brush cache
-	float RemapValue(float value); // remaps a single value of a map to nonlinear scale in order to smooth beach areas
-
-public:
-	//ErosionMaker(ErosionMaker const &) = delete;
-	//void operator=(ErosionMaker const &) = delete;
-
-	// Note: Scott Meyers mentions in his Effective Modern
-	//       C++ book, that deleted functions should generally
-	//       be public as it results in better error messages
-	//       due to the compilers behavior to check accessibility
-	//       before deleted status
-
-	//int seed = 0;
-	int erosionRadius = 6;//12; // Range (2, 8)
-
-	float inertia = 0.05f; // range (0, 1) at zero, water will instantly change direction to flow downhill. At 1, water will never change direction. 
-	float sedimentCapacityFactor = 6.0f; // multiplier for how much sediment a droplet can carry
-	float minSedimentCapacity = 0.01f; // used to prevent carry capacity getting too close to zero on flatter terrain
-	float erodeSpeed = 0.3f; // range (0, 1) how easily a droplet removes sediment
-	float depositSpeed = 0.3f; // range (0, 1) how easily a droplet deposits sediment
-	float evaporateSpeed = 0.01f; // range (0, 1) droplets evaporate during their lifetime, reducing mass
-	float gravity = 4.0f; // determines speed increase of the droplet upon a slope
-	int maxDropletLifetime = 60;
-
-	float initialWaterVolume = 1;
-	float initialSpeed = 1;
-
-	void Erode(std::vector<float>* map, int mapSize, int numIterations = 1, bool resetSeed = false); // applies erosion to the map
-	void Gradient(std::vector<float>* map, int mapSize, float normalizedOffset, GradientType gradientType); // allpies a gradient to the map in order to get flat borders
-	Vector3 GetNormal(std::vector<float>* map, int mapSize, int x, int y); // gets the normal of a point in the map using interpolation
-	void Remap(std::vector<float>* map, int mapSize); // applies a filter to the map in order to flatten beach areas by remapping normalized values
-};
-
+#ifndef EROSION_MAKER
+#define EROSION_MAKER
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "raylib.h"
+#include "HeightmapLayout.h"
+#include "RemapCurve.h"
+
+// used to sample a point in the heightmap and get the gradient
+typedef struct
+{
+	float height;
+	float gradientX;
+	float gradientY;
+} HeightAndGradient;
+
+// horizontal run of cells of the erosion brush, lets a whole row be eroded with contiguous (SIMD) loads
+typedef struct
+{
+	int indexOffset; // offset in the map of the first cell of the run, relative to the brush center
+	int firstPoint; // index of the first cell of the run in the brush arrays
+	int count; // number of cells in the run
+} BrushRow;
+
+// kernel used to simulate droplets
+enum ErosionKernel
+{
+	SCALAR = 0, // one droplet at a time, reference implementation
+	PACKET = 1, // packets of droplets advanced in lockstep with SIMD (AVX-512 or AVX2 picked at runtime, scalar otherwise)
+};
+
+// erosion model simulated by Erode
+enum ErosionModel
+{
+	DROPLETS = 0, // particles running downhill one after the other, Erode iterations are droplets
+	PIPES = 1, // shallow water "virtual pipe" grid, Erode iterations are time steps over the whole map
+};
+
+// progress of an erosion started with StartErode
+typedef struct
+{
+	long long requested; // iterations (droplets or pipe iterations) to simulate, 0 = until cancelled
+	long long done; // iterations simulated so far
+	bool finished; // all requested iterations were simulated, or the erosion was cancelled
+	bool cancelled;
+} ErosionProgress;
+
+// droplet statistics cost a few counters per droplet, build with EROSION_STATISTICS defined as 0 to compile them out of the kernels
+#ifndef EROSION_STATISTICS
+#define EROSION_STATISTICS 1
+#endif
+#if EROSION_STATISTICS
+#define DROPLET_STATISTICS(...) __VA_ARGS__
+#else
+#define DROPLET_STATISTICS(...)
+#endif
+
+// why a droplet stopped being simulated
+enum DropletEnd
+{
+	EDGE = 0, // flowed over the edge of the map
+	STALLED = 1, // stopped moving (flat ground or a pit)
+	LIFETIME = 2, // lived maxDropletLifetime steps
+};
+
+// what the droplets of Erode calls did, gathered by every pool thread on its own and merged at the end of each call
+typedef struct
+{
+	std::vector<long long> lifetimes; // droplets by the number of steps they lived (index), up to maxDropletLifetime
+	long long droplets = 0;
+	long long ends[3] = { 0, 0, 0 }; // droplets by DropletEnd
+	long long erodeSteps = 0; // steps that eroded around the droplet
+	long long depositSteps = 0; // steps that deposited sediment in the droplet's cell
+	long long nanSpeeds = 0; // steps where speed * speed + deltaHeight * gravity was negative and the speed was reset to 0
+	double eroded = 0.0; // material removed from the map
+	double deposited = 0.0; // material put back on the map, the difference left it with the droplets
+} DropletStatistics;
+
+// describes the shape of the smoothing to apply to map borders
+enum GradientType
+{
+	SQUARE = 0,
+	CIRCLE = 1,
+	DIAMOND = 2,
+	STAR = 3,
+};
+
+// fractal noise of the base heightmaps generated by ErosionMaker::GenerateNoise
+enum NoiseType
+{
+	FBM = 0, // fractional Brownian motion: octaves of gradient noise, rolling hills
+	RIDGED = 1, // ridged multifractal: sharp crests along the zero crossings, mountain ranges
+	DOMAIN_WARPED = 2, // fBm of coordinates moved by coarser fBm, twisted eroded-looking shapes
+};
+
+// tunables of ErosionMaker::GenerateNoise, the same parameters give the same heights on any CPU and thread count
+typedef struct
+{
+	NoiseType type = NoiseType::FBM;
+	unsigned int seed = 0;
+	int octaves = 6; // at most 16
+	float lacunarity = 2.0f; // frequency of an octave relative to the previous one
+	float gain = 0.5f; // amplitude of an octave relative to the previous one
+	float scale = 4.0f; // periods of the base octave across the map
+	float offsetX = 50.0f; // cells the map is moved by in the noise, like GenImagePerlinNoise's offsets
+	float offsetY = 50.0f;
+	float warpStrength = 0.5f; // domain warped: how far (in base periods) the coordinates are moved
+	int warpOctaves = 4; // domain warped: octaves of the two warp fields, at most 16
+} NoiseParameters;
+
+// tunables of the erosion jobs. a job (Erode, StartErode / ContinueErode, ErodeThermal, ErodeMultiresolution) copies the
+// parameters of its erosion maker when it starts and only reads its copy, so changing them never affects a running job
+typedef struct
+{
+	int erosionRadius = 6; // Range (2, 8)
+
+	float inertia = 0.05f; // range (0, 1) at zero, water will instantly change direction to flow downhill. At 1, water will never change direction. 
+	float sedimentCapacityFactor = 6.0f; // multiplier for how much sediment a droplet can carry
+	float minSedimentCapacity = 0.01f; // used to prevent carry capacity getting too close to zero on flatter terrain
+	float erodeSpeed = 0.3f; // range (0, 1) how easily a droplet removes sediment
+	float depositSpeed = 0.3f; // range (0, 1) how easily a droplet deposits sediment
+	float evaporateSpeed = 0.01f; // range (0, 1) droplets evaporate during their lifetime, reducing mass
+	float gravity = 4.0f; // determines speed increase of the droplet upon a slope
+	int maxDropletLifetime = 60;
+
+	float initialWaterVolume = 1;
+	float initialSpeed = 1;
+
+	// virtual pipe model, units are map cells and map heights
+	float pipeTimeStep = 0.05f; // simulated time of an iteration
+	float pipeCellLength = 1.0f / 128.0f; // horizontal size of a cell in height units (a 512 map spans 4 times its max height)
+	float pipeRainRate = 0.0002f; // water height added to every cell per unit of time
+	float pipeGravity = 9.81f;
+	float pipeSedimentCapacity = 0.1f; // how much sediment the flow can carry for a given slope and speed
+	float pipeDissolveSpeed = 0.5f; // how fast terrain is dissolved when the flow can carry more
+	float pipeDepositSpeed = 1.0f; // how fast sediment settles when the flow carries too much
+	float pipeEvaporateSpeed = 0.5f; // fraction of water evaporated per unit of time
+	float pipeMinTilt = 0.05f; // keeps some capacity on flat ground
+	float pipeErosionDepth = 0.001f; // water height below which the carry capacity fades out
+
+	// thermal erosion
+	float thermalTalusAngle = 40.0f; // steepest stable slope in degrees, steeper slopes crumble
+	float thermalCellLength = 1.0f / 128.0f; // horizontal size of a cell in height units, converts the angle to a height difference
+	float thermalRate = 0.25f; // range (0, 0.5) fraction of the excess height moved per iteration
+
+	// multiresolution erosion
+	float multiresolutionDropletGain = 4.0f; // droplets of a level relative to the next finer one, coarse droplets are far cheaper
+
+	ErosionModel model = ErosionModel::DROPLETS; // erosion model simulated by Erode
+	int threadCount = 0; // threads used by Erode, 0 = all hardware threads (doesn't change the result)
+	ErosionKernel kernel = ErosionKernel::SCALAR; // droplet kernel used by Erode
+	// storage the scalar kernel erodes in: TILED copies the map to blocks at the start of Erode and the changed tiles back at the end,
+	// it pays off on maps too large for the cache (the result is the same)
+	HeightmapLayout layout = HeightmapLayout::ROW_MAJOR;
+} ErosionParameters;
+
+// erosion brush of a radius for maps of a width: a circular stencil of offsets and weights around the droplet's cell.
+// cells closer than the radius to the map border clip the stencil on the fly and renormalize its weights.
+// brushes are read-only once built and shared by every erosion maker through ErosionMaker::GetBrush
+typedef struct
+{
+	int radius;
+	int mapWidth; // width the index offsets and rows are computed for
+	std::vector<int> offsetsX; // horizontal offset of every brush point
+	std::vector<int> offsetsY; // vertical offset of every brush point
+	std::vector<int> indexOffsets; // offset of every brush point in the map
+	std::vector<float> rawWeights; // weights before normalization, used to renormalize clipped brushes
+	std::vector<float> weights; // normalized weights of the full (interior) brush
+	std::vector<BrushRow> rows; // the full brush as horizontal runs
+} ErosionBrush;
+
+// simulates erosion on heightmaps. instances are independent: every map can have its own, and instances can erode
+// concurrently from different threads (they share the thread pool and the read-only brushes). an instance runs one job at a time
+class ErosionMaker
+{
+	friend class ErosionBenchmark; // times the private kernels (brush, height and gradient)
+	template <class Lanes> friend class DropletPackets; // packet kernel of an instruction set (ErosionMakerPacket.h)
+
+public:
+	// instance shared by the modules of the interactive application
+	static ErosionMaker& GetInstance()
+	{
+		static ErosionMaker instance; // created on first use
+		return instance;
+	}
+
+	explicit ErosionMaker(const ErosionParameters& parameters = ErosionParameters()) : parameters(parameters)
+	{
+		incrementalRequested = 0;
+		incrementalDone = 0;
+		incrementalFinished = true;
+		incrementalCancelled = false;
+		cancelRequested = false;
+	}
+
+	ErosionMaker(ErosionMaker const&) = delete;
+	void operator=(ErosionMaker const&) = delete;
+
+	ErosionParameters parameters; // parameters of the jobs started from now on
+	RemapCurve remapCurve; // curve of Remap and ShapeIsland, the beach curve unless set
+
+private:
+	ErosionParameters job; // copy of the parameters the running job reads, set when it starts
+	ErosionParameters incrementalParameters; // copy taken by StartErode for the ContinueErode batches
+
+	std::shared_ptr<const ErosionBrush> brush; // brush of job.erosionRadius for the map being eroded, from GetBrush
+
+	// virtual pipe model state, one value per cell, kept between Erode calls
+	std::vector<float> pipeWater; // height of water above the terrain
+	std::vector<float> pipeSediment; // sediment suspended in the water
+	std::vector<float> pipeSedimentNext; // transported sediment being computed
+	std::vector<float> pipeTerrainNext; // eroded terrain being computed
+	std::vector<float> pipeFluxLeft; // outflow towards each neighbor
+	std::vector<float> pipeFluxRight;
+	std::vector<float> pipeFluxTop;
+	std::vector<float> pipeFluxBottom;
+	std::vector<float> pipeVelocityX; // velocity of the water
+	std::vector<float> pipeVelocityY;
+	std::vector<float> pipeOutflowRatio; // fraction of the cell content leaving per unit of outflow flux, used to move sediment with the water
+	int pipeMapWidth = 0; // size the pipe fields are allocated for, 0 = reset
+	int pipeMapHeight = 0;
+
+	std::vector<float> tiledMap; // copy of the map in the TILED layout while Erode runs droplets on it
+
+	// thermal erosion buffers
+	std::vector<float> thermalTerrainNext; // map being computed, swapped with the map after every iteration
+	std::vector<float> thermalOutflowScale; // share of its excess every cell gives to each lower neighbor
+
+	// incremental erosion (StartErode / ContinueErode)
+	std::atomic<long long> incrementalRequested;
+	std::atomic<long long> incrementalDone;
+	std::atomic<bool> incrementalFinished;
+	std::atomic<bool> incrementalCancelled;
+	std::atomic<bool> cancelRequested; // set from any thread by CancelErode, checked between batches
+	double secondsPerIteration[2] = { 0.0, 0.0 }; // measured cost of an iteration of each model, 0 = not measured yet
+
+	// tiles of DIRTY_TILE_SIZE x DIRTY_TILE_SIZE cells changed since the last TakeDirtyTiles, one bit per tile in row-major order
+	std::vector<unsigned long long> dirtyTiles;
+	std::vector<std::vector<unsigned long long>> workerDirtyTiles; // filled by each pool thread during Erode and ErodeThermal, merged at the end
+
+	DropletStatistics dropletStatistics; // gathered since the last ResetDropletStatistics
+	std::vector<DropletStatistics> workerStatistics; // filled by each pool thread during Erode, merged at the end
+	int dirtyMapWidth = 0;
+	int dirtyMapHeight = 0;
+
+	unsigned int currentSeed = 0; // seed of the droplet spawn sequence
+	unsigned long long dropletCounter = 0; // droplets simulated since the seed was set, index of the next droplet
+	void Initialize(int mapWidth, bool resetSeed); // picks the brush of the job for the map and reseeds if asked
+	void ErodeJob(std::vector<float>* map, int mapWidth, int mapHeight, int numIterations, bool resetSeed); // Erode with the parameters in job
+	void SimulateDroplets(std::vector<float>* map, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics); // runs droplets in order with the selected kernel
+	void SimulateDroplet(std::vector<float>* map, int mapWidth, int mapHeight, float posX, float posY, unsigned long long* dirty, DropletStatistics* statistics); // runs a single droplet from its spawn point until it dies
+	template <class Layout> void SimulateDropletIn(float* heights, const Layout& cells, int mapWidth, int mapHeight, float posX, float posY, unsigned long long* dirty, DropletStatistics* statistics);
+	bool UsesTiledMap() { return job.layout == HeightmapLayout::TILED && job.model == ErosionModel::DROPLETS && job.kernel == ErosionKernel::SCALAR; }
+	void SimulateDropletPackets(std::vector<float>* map, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics); // runs droplets in SIMD packets (ErosionMakerPacket.cpp)
+	void ErodePipes(std::vector<float>* map, int mapWidth, int mapHeight, int iterations); // runs the virtual pipe model (ErosionMakerPipes.cpp)
+	static void MarkThermalRow(const float* outflowScale, int mapWidth, int mapHeight, int y, unsigned long long* dirty); // marks the tiles a thermal iteration changes around the shedding cells of a row (ErosionMakerThermal.cpp)
+	int GetDropletReach(); // max distance (in cells) from its spawn point at which a droplet can read or write the map
+	template <class Layout> HeightAndGradient CalculateHeightAndGradient(const float* heights, const Layout& cells, float posX, float posY); // calculates height and gradient of a spot in the map
+	static void InitializeBrushIndices(ErosionBrush* brush, int mapWidth, int radius); // builds the brush stencil
+	// erode around a node and add the removed material to sediment, row-major maps use the precomputed index offsets of the brush
+	void ErodeWithBrush(float* heights, const RowMajorLayout& cells, int mapWidth, int mapHeight, int nodeX, int nodeY, float amountToErode, float& sediment);
+	void ErodeWithBrush(float* heights, const TiledLayout& cells, int mapWidth, int mapHeight, int nodeX, int nodeY, float amountToErode, float& sediment);
+	template <class Layout> void ErodeWithClippedBrush(float* heights, const Layout& cells, int mapWidth, int mapHeight, int nodeX, int nodeY, float amountToErode, float& sediment);
+	template <class Layout> Vector3 CalculateNormal(const float* heights, const Layout& cells, int mapWidth, int mapHeight, int x, int y);
+	void PrepareDirtyTiles(int mapWidth, int mapHeight); // sizes the dirty tile masks for the map
+	void MarkAllDirty(int mapWidth, int mapHeight);
+	static void AddDropletStatistics(DropletStatistics* total, const DropletStatistics& statistics);
+
+	// counts a droplet that ended after the given steps
+	static void RecordDroplet(DropletStatistics* statistics, int steps, DropletEnd end)
+	{
+		if ((size_t)steps >= statistics->lifetimes.size())
+			statistics->lifetimes.resize((size_t)steps + 1, 0);
+		statistics->lifetimes[steps]++;
+		statistics->droplets++;
+		statistics->ends[end]++;
+	}
+
+	// marks the tiles overlapping the cells from (minX, minY) to (maxX, maxY) included, clipped to the map
+	static void MarkDirtyRect(unsigned long long* dirty, int mapWidth, int mapHeight, int minX, int minY, int maxX, int maxY)
+	{
+		int tileColumns = GetDirtyTileCount(mapWidth);
+		int firstX = std::max(minX, 0) / DIRTY_TILE_SIZE;
+		int lastX = std::min(maxX, mapWidth - 1) / DIRTY_TILE_SIZE;
+		int firstY = std::max(minY, 0) / DIRTY_TILE_SIZE;
+		int lastY = std::min(maxY, mapHeight - 1) / DIRTY_TILE_SIZE;
+		for (int tileY = firstY; tileY <= lastY; tileY++)
+		{
+			for (int tileX = firstX; tileX <= lastX; tileX++)
+			{
+				size_t tile = (size_t)tileY * tileColumns + tileX;
+				dirty[tile >> 6] |= 1ull << (tile & 63);
+			}
+		}
+	}
+
+	// marks the tiles a droplet on the node can write: the erosion brush around it, or the four nodes of its cell
+	void MarkDirtyNode(unsigned long long* dirty, int mapWidth, int mapHeight, int nodeX, int nodeY)
+	{
+		int reach = std::max(brush->radius, 1);
+		MarkDirtyRect(dirty, mapWidth, mapHeight, nodeX - reach, nodeY - reach, nodeX + reach, nodeY + reach);
+	}
+
+public:
+	float dropletsPerSecond = 0; // throughput measured during the last Erode call
+
+	static const int DIRTY_TILE_SIZE = 32; // side in cells of the tiles tracked by the dirty mask
+	static int GetDirtyTileCount(int cells) { return (cells + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE; } // tiles along an axis of the given length
+
+	// maps are row-major arrays of mapWidth * mapHeight heights, both sizes at least 2 (3 for thermal erosion)
+	void Erode(std::vector<float>* map, int mapWidth, int mapHeight, int numIterations = 1, bool resetSeed = false); // applies erosion to the map
+	void StartErode(long long numIterations); // starts a resumable erosion of numIterations (0 = until cancelled), run it with ContinueErode
+	ErosionProgress ContinueErode(std::vector<float>* map, int mapWidth, int mapHeight, float budgetSeconds); // simulates as many iterations of the started erosion as fit in the budget
+	void CancelErode(); // stops the started erosion at the next batch, can be called from any thread. stays requested until ClearCancel
+	void ClearCancel(); // lets the next erosion run, called when the erosion is requested (not when it starts) so a cancel in between isn't lost
+	ErosionProgress GetErodeProgress(); // can be called from any thread
+	void TakeDirtyTiles(std::vector<unsigned long long>* tiles, int mapWidth, int mapHeight); // gets the tiles changed since the last call (one bit per tile, row-major) and clears them
+	void SetSeed(unsigned int seed); // restarts the droplet sequence from the given seed
+	void ResetPipeState(); // removes water and suspended sediment of the virtual pipe model
+	void ErodeThermal(std::vector<float>* map, int mapWidth, int mapHeight, int iterations = 1); // moves material down slopes steeper than the talus angle (ErosionMakerThermal.cpp)
+	// erodes levels of the map halved up to levels times, coarsest first, with numIterations droplets on the map itself and
+	// multiresolutionDropletGain times more on every coarser level (droplets only, ErosionMakerPyramid.cpp). CancelErode stops it, the map is untouched unless the last level had started
+	// (finished is false then, the dirty tiles cover the whole map once it changed)
+	ErosionProgress ErodeMultiresolution(std::vector<float>* map, int mapWidth, int mapHeight, int numIterations, int levels = 3);
+	unsigned int GetSeed() { return currentSeed; }
+	unsigned long long GetDropletCounter() { return dropletCounter; } // droplets simulated since the seed was set
+	DropletStatistics GetDropletStatistics() { return dropletStatistics; } // what the droplets did since the last reset (empty when built without EROSION_STATISTICS)
+	void ResetDropletStatistics() { dropletStatistics = DropletStatistics(); }
+	Vector2 GetDropletSpawn(unsigned long long dropletIndex, int mapWidth, int mapHeight); // spawn point of the given droplet of the current seed
+	static const char* GetPacketInstructionSet(); // SIMD instruction set used by the packet kernel on this CPU
+	static bool HasPacketKernel(); // false when the packet kernel runs the scalar one: no instruction set compiled in or supported by this CPU
+	static std::shared_ptr<const ErosionBrush> GetBrush(int mapWidth, int radius); // brush from the process-wide cache, built on first use, any thread
+	void Gradient(std::vector<float>* map, int mapWidth, int mapHeight, float normalizedOffset, GradientType gradientType); // allpies a gradient to the map in order to get flat borders
+	Vector3 GetNormal(std::vector<float>* map, int mapWidth, int mapHeight, int x, int y); // gets the normal of a point in the map using interpolation
+	void Remap(std::vector<float>* map, int mapWidth, int mapHeight); // applies remapCurve to the map (multithreaded) in order to flatten beach areas by remapping normalized values
+	// Gradient then Remap of the noise in a single multithreaded pass (ErosionMakerIsland.cpp), same heights bit for bit.
+	// heights can be the noise itself (in place). values (nullptr = none) receives the heights encoded for upload by
+	// EncodeHeights while the rows are still in the cache
+	void ShapeIsland(const float* noise, float* heights, unsigned short* values, int mapWidth, int mapHeight, GradientType gradientType);
+	static void EncodeHeights(const float* heights, unsigned short* values, int count); // range (0, 1) heights to 16 bit values, clamped (HeightmapTexture)
+	// writes range (0, 1) noise to the mapWidth * mapHeight heights with SIMD on parameters.threadCount threads (ErosionMakerNoise.cpp)
+	void GenerateNoise(float* heights, int mapWidth, int mapHeight, const NoiseParameters& noise);
+	static float SampleNoise(int x, int y, int mapWidth, int mapHeight, const NoiseParameters& noise); // height of one cell of GenerateNoise, scalar
+};
+
 #endif
\ No newline at end of file
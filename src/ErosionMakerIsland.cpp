@@ -0,0 +1,171 @@
+#include "FloatContract.h"
+#include "ErosionMaker.h"
+#include <math.h>
+#include <algorithm>
+#include "ThreadPool.h"
+
+// fused island shaping: the noise is masked by the island gradient, remapped and encoded for upload in a single sweep,
+// a band of rows per task, instead of a pass over the whole map for every step. the gradient type is a template
+// parameter so the inner loop has no switch, and the loop handles 4 cells at a time with SSE2 (always there on x64).
+// every lane does the operations of Gradient in the same order, and the rows go through the same table lookup of the
+// remap curve as Remap, so the heights are the same bit for bit
+
+// SSE2 is always there on x64, other targets shape one cell at a time
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ISLAND_SSE2
+#endif
+
+static const int ISLAND_ROWS_PER_TASK = 16; // rows of the map shaped by a single task
+
+struct IslandLanesScalar
+{
+	static const int WIDTH = 1;
+
+	typedef float F;
+
+	static F Set(float a) { return a; }
+	static F Columns(int x) { return (float)x; } // coordinates of the cells starting at column x
+	static F Load(const float* p) { return *p; }
+	static void Store(float* p, F a) { *p = a; }
+	static F Add(F a, F b) { return a + b; }
+	static F Sub(F a, F b) { return a - b; }
+	static F Mul(F a, F b) { return a * b; }
+	static F Div(F a, F b) { return a / b; }
+	static F Abs(F a) { return fabsf(a); }
+	static F Min(F a, F b) { return std::min(a, b); }
+	static F Max(F a, F b) { return std::max(a, b); }
+};
+
+#ifdef ISLAND_SSE2
+struct IslandLanesSse2
+{
+	static const int WIDTH = 4;
+
+	typedef __m128 F;
+
+	static F Set(float a) { return _mm_set1_ps(a); }
+	static F Columns(int x) { return _mm_add_ps(_mm_set1_ps((float)x), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)); } // exact below 2^24
+	static F Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, F a) { _mm_storeu_ps(p, a); }
+	static F Add(F a, F b) { return _mm_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static F Div(F a, F b) { return _mm_div_ps(a, b); }
+	static F Abs(F a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))); }
+	// std::min and std::max pick the same operand for ordered values (heights and distances are never NaN)
+	static F Min(F a, F b) { return _mm_min_ps(a, b); }
+	static F Max(F a, F b) { return _mm_max_ps(a, b); }
+};
+#endif
+
+// distance to the center in the metric of the gradient, 0 at the center and 1 on the shore, dx and dy are absolute
+template <class Lanes, GradientType type>
+static typename Lanes::F IslandDistance(typename Lanes::F dx, typename Lanes::F dy, typename Lanes::F radius)
+{
+	typedef Lanes L;
+	switch (type)
+	{
+	case GradientType::SQUARE:
+		return L::Div(L::Max(dx, dy), radius); // Chebyshev distance
+	case GradientType::DIAMOND:
+		return L::Min(L::Div(L::Add(dx, dy), radius), L::Set(1.0f)); // Manhattan distance
+	case GradientType::STAR:
+	{
+		typename L::F manhattan = L::Min(L::Div(L::Add(dx, dy), radius), L::Set(1.0f));
+		typename L::F chebyshev = L::Div(L::Max(dx, dy), radius);
+		return L::Add(manhattan, L::Mul(L::Set(0.7f), L::Sub(chebyshev, manhattan))); // Lerp(manhattan, chebyshev, 0.7f)
+	}
+	default:
+		return L::Min(L::Div(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), L::Mul(radius, radius)), L::Set(1.0f)); // Euclidean distance
+	}
+}
+
+// shapes cells [first, last) of a row, returns the first cell not shaped (the tail narrower than the lanes)
+template <class Lanes, GradientType type>
+static int ShapeIslandCells(const float* noise, float* heights, int first, int last, float radius, float y)
+{
+	typedef Lanes L;
+	const typename L::F center = L::Set(radius);
+	const typename L::F dy = L::Abs(L::Sub(L::Set(y), center)); // squared by the Euclidean distance, the sign doesn't matter
+	int x = first;
+	for (; x + L::WIDTH <= last; x += L::WIDTH)
+	{
+		typename L::F dx = L::Abs(L::Sub(L::Columns(x), center));
+		typename L::F gradient = L::Sub(L::Set(1.0f), IslandDistance<Lanes, type>(dx, dy, center)); // invert
+		L::Store(heights + x, L::Mul(L::Load(noise + x), gradient));
+	}
+	return x;
+}
+
+template <GradientType type>
+static void ShapeIslandRows(const float* noise, float* heights, unsigned short* values, int mapWidth, int mapHeight, int threads, const RemapCurve& curve)
+{
+	// same coordinates as Gradient: distances in units of the horizontal radius, rows stretched to fill rectangular maps
+	float radius = ((float)mapWidth / 2.0f);
+	float radiusY = ((float)mapHeight / 2.0f);
+	float stretchY = radius / radiusY;
+	ThreadPool::GetInstance().ParallelForRows(mapHeight, ISLAND_ROWS_PER_TASK, threads, [&](int firstRow, int lastRow)
+	{
+		for (int row = firstRow; row < lastRow; row++)
+		{
+			size_t offset = (size_t)row * mapWidth;
+			float y = radius + ((float)row - radiusY) * stretchY;
+			int x = 0;
+#ifdef ISLAND_SSE2
+			x = ShapeIslandCells<IslandLanesSse2, type>(noise + offset, heights + offset, x, mapWidth, radius, y);
+#endif
+			ShapeIslandCells<IslandLanesScalar, type>(noise + offset, heights + offset, x, mapWidth, radius, y);
+			curve.Apply(heights + offset, mapWidth);
+			if (values != nullptr)
+				ErosionMaker::EncodeHeights(heights + offset, values + offset, mapWidth);
+		}
+	});
+}
+
+void ErosionMaker::ShapeIsland(const float* noise, float* heights, unsigned short* values, int mapWidth, int mapHeight, GradientType gradientType)
+{
+	int threads = (parameters.threadCount <= 0) ? ThreadPool::GetHardwareThreadCount() : parameters.threadCount;
+	switch (gradientType)
+	{
+	case GradientType::SQUARE:
+		ShapeIslandRows<GradientType::SQUARE>(noise, heights, values, mapWidth, mapHeight, threads, remapCurve);
+		break;
+	case GradientType::DIAMOND:
+		ShapeIslandRows<GradientType::DIAMOND>(noise, heights, values, mapWidth, mapHeight, threads, remapCurve);
+		break;
+	case GradientType::STAR:
+		ShapeIslandRows<GradientType::STAR>(noise, heights, values, mapWidth, mapHeight, threads, remapCurve);
+		break;
+	default:
+		ShapeIslandRows<GradientType::CIRCLE>(noise, heights, values, mapWidth, mapHeight, threads, remapCurve);
+		break;
+	}
+}
+
+void ErosionMaker::EncodeHeights(const float* heights, unsigned short* values, int count)
+{
+	int i = 0;
+#ifdef ISLAND_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(65535.0f);
+	const __m128i bias = _mm_set1_epi32(32768);
+	const __m128i signBit = _mm_set1_epi16((short)0x8000);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 low = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(heights + i), zero), one), scale);
+		__m128 high = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(heights + i + 4), zero), one), scale);
+		// SSE2 only packs to signed 16 bit: shift the values to the signed range, pack, then flip the sign bit back
+		__m128i lowInt = _mm_sub_epi32(_mm_cvtps_epi32(low), bias);
+		__m128i highInt = _mm_sub_epi32(_mm_cvtps_epi32(high), bias);
+		__m128i packed = _mm_xor_si128(_mm_packs_epi32(lowInt, highInt), signBit);
+		_mm_storeu_si128((__m128i*)(values + i), packed);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float height = std::min(1.0f, std::max(0.0f, heights[i])); // NaN gives 0 like the SSE2 path
+		values[i] = (unsigned short)lrintf(height * 65535.0f); // rounds to nearest even like the conversion above
+	}
+}
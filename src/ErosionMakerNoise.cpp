@@ -0,0 +1,479 @@
+#include "FloatContract.h"
+#include "ErosionMaker.h"
+#include <math.h>
+#include <algorithm>
+#include "ThreadPool.h"
+
+// base heightmaps: fractal gradient noise evaluated straight into the float map, a band of rows per task and 4 cells at a
+// time with SSE2. the lattice gradients come from an integer hash of the corner instead of a permutation table, so the
+// lanes need no gathers. along a row everything that depends on y is computed once per octave, and the gradients of the
+// lattice cell the lanes are in are kept until they leave it: a row crosses a cell every mapWidth / (scale * frequency)
+// cells. the rows do the operations of the plain per-cell evaluation (SampleNoise) in the same order, the heights
+// don't depend on the thread count or the instruction set
+
+// SSE2 is always there on x64, other targets evaluate one cell at a time
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NOISE_SSE2
+#endif
+
+static const int NOISE_ROWS_PER_TASK = 16; // rows of the map generated by a single task
+static const int NOISE_MAX_OCTAVES = 16; // octaves past it are below the resolution of any map
+static const unsigned int NOISE_PRIME_X = 0x8DA6B343u; // lattice hash, large odd constants spread the cells over the bits
+static const unsigned int NOISE_PRIME_Y = 0xD8163841u;
+static const unsigned int NOISE_MIX_1 = 0x7FEB352Du;
+static const unsigned int NOISE_MIX_2 = 0x846CA68Bu;
+static const unsigned int NOISE_OCTAVE_SEED = 0x9E3779B9u; // seed step between octaves
+static const float NOISE_OCTAVE_SHIFT = 0.5137f; // offset between octaves, keeps their lattices from lining up at the origin
+static const float NOISE_FBM_CONTRAST = 1.23f; // fBm: brings the spread of the heights to the one of the stb_perlin noise it replaced
+static const float NOISE_RIDGE_SHARPNESS = 2.0f; // ridged: how much a ridge masks the finer octaves around it
+static const float NOISE_WARP_SHIFT_X = 5.2f; // domain warp: offset of the second warp field
+static const float NOISE_WARP_SHIFT_Y = 1.3f;
+
+struct NoiseLanesScalar
+{
+	static const int WIDTH = 1;
+
+	typedef float F;
+	typedef unsigned int I;
+
+	static F Set(float a) { return a; }
+	static I SetInt(unsigned int a) { return a; }
+	static F Columns(int x) { return (float)x; } // coordinates of the cells starting at column x
+	static void Store(float* p, F a) { *p = a; }
+	static F Add(F a, F b) { return a + b; }
+	static F Sub(F a, F b) { return a - b; }
+	static F Mul(F a, F b) { return a * b; }
+	static F Div(F a, F b) { return a / b; }
+	static F Abs(F a) { return fabsf(a); }
+	static F Min(F a, F b) { return (a < b) ? a : b; } // picks the operand _mm_min_ps picks
+	static F Max(F a, F b) { return (a > b) ? a : b; }
+	static F Floor(F a) { return floorf(a); }
+	static bool SameValue(F a, float* value) { *value = a; return true; } // whether every lane holds the same value, returned
+	static I ToInt(F a) { return (unsigned int)(int)a; } // of whole numbers
+	static F ToFloat(I a) { return (float)(int)a; } // of values below 2^24
+	static I AddInt(I a, I b) { return a + b; }
+	static I MulInt(I a, I b) { return a * b; } // low 32 bits
+	static I Xor(I a, I b) { return a ^ b; }
+	static I AndInt(I a, I b) { return a & b; }
+	static I ShiftRight(I a, int bits) { return a >> bits; }
+};
+
+#ifdef NOISE_SSE2
+struct NoiseLanesSse2
+{
+	static const int WIDTH = 4;
+
+	typedef __m128 F;
+	typedef __m128i I;
+
+	static F Set(float a) { return _mm_set1_ps(a); }
+	static I SetInt(unsigned int a) { return _mm_set1_epi32((int)a); }
+	static F Columns(int x) { return _mm_add_ps(_mm_set1_ps((float)x), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)); } // exact below 2^24
+	static void Store(float* p, F a) { _mm_storeu_ps(p, a); }
+	static F Add(F a, F b) { return _mm_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static F Div(F a, F b) { return _mm_div_ps(a, b); }
+	static F Abs(F a) { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))); }
+	static F Min(F a, F b) { return _mm_min_ps(a, b); }
+	static F Max(F a, F b) { return _mm_max_ps(a, b); }
+	static F Floor(F a)
+	{
+		// SSE2 only truncates: one less where truncation went up (negative values with a fraction)
+		F truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1.0f)));
+	}
+	static bool SameValue(F a, float* value)
+	{
+		*value = _mm_cvtss_f32(a);
+		return _mm_movemask_ps(_mm_cmpeq_ps(a, _mm_set1_ps(*value))) == 0xF;
+	}
+	static I ToInt(F a) { return _mm_cvttps_epi32(a); }
+	static F ToFloat(I a) { return _mm_cvtepi32_ps(a); }
+	static I AddInt(I a, I b) { return _mm_add_epi32(a, b); }
+	static I MulInt(I a, I b)
+	{
+		// no 32 bit multiply before SSE4.1: even and odd lanes as 64 bit products, then their low halves put back together
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+	static I Xor(I a, I b) { return _mm_xor_si128(a, b); }
+	static I AndInt(I a, I b) { return _mm_and_si128(a, b); }
+	static I ShiftRight(I a, int bits) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(bits)); }
+};
+#endif
+
+// gradient of a lattice corner from a hash of the corner: 16 bits per component, in (-1, 1)
+template <class Lanes>
+static void CornerGradient(typename Lanes::I cornerX, typename Lanes::I cornerY, typename Lanes::F* gradientX, typename Lanes::F* gradientY)
+{
+	typedef Lanes L;
+	typename L::I hash = L::MulInt(L::Xor(cornerX, cornerY), L::SetInt(NOISE_MIX_1));
+	hash = L::Xor(hash, L::ShiftRight(hash, 15));
+	hash = L::MulInt(hash, L::SetInt(NOISE_MIX_2));
+	hash = L::Xor(hash, L::ShiftRight(hash, 16));
+	const typename L::F unit = L::Set(1.0f / 32767.5f);
+	*gradientX = L::Sub(L::Mul(L::ToFloat(L::AndInt(hash, L::SetInt(0xFFFF))), unit), L::Set(1.0f));
+	*gradientY = L::Sub(L::Mul(L::ToFloat(L::ShiftRight(hash, 16)), unit), L::Set(1.0f));
+}
+
+// dot product of the gradient of a lattice corner with the offset to it
+template <class Lanes>
+static typename Lanes::F CornerDot(typename Lanes::F gradientX, typename Lanes::F gradientY, typename Lanes::F dx, typename Lanes::F dy)
+{
+	typedef Lanes L;
+	return L::Add(L::Mul(gradientX, dx), L::Mul(gradientY, dy));
+}
+
+template <class Lanes>
+static typename Lanes::F CornerDot(typename Lanes::I cornerX, typename Lanes::I cornerY, typename Lanes::F dx, typename Lanes::F dy)
+{
+	typename Lanes::F gradientX, gradientY;
+	CornerGradient<Lanes>(cornerX, cornerY, &gradientX, &gradientY);
+	return CornerDot<Lanes>(gradientX, gradientY, dx, dy);
+}
+
+// quintic fade of Perlin's improved noise, zero first and second derivatives at the lattice
+template <class Lanes>
+static typename Lanes::F Fade(typename Lanes::F t)
+{
+	typedef Lanes L;
+	typename L::F polynomial = L::Add(L::Mul(t, L::Sub(L::Mul(t, L::Set(6.0f)), L::Set(15.0f))), L::Set(10.0f));
+	return L::Mul(L::Mul(L::Mul(t, t), t), polynomial);
+}
+
+// the corner values blended by the faded offsets
+template <class Lanes>
+static typename Lanes::F Blend(typename Lanes::F n00, typename Lanes::F n10, typename Lanes::F n01, typename Lanes::F n11, typename Lanes::F u, typename Lanes::F v)
+{
+	typedef Lanes L;
+	typename L::F bottom = L::Add(n00, L::Mul(u, L::Sub(n10, n00)));
+	typename L::F top = L::Add(n01, L::Mul(u, L::Sub(n11, n01)));
+	return L::Add(bottom, L::Mul(v, L::Sub(top, bottom)));
+}
+
+// hashes of the lattice rows (or columns) around a cell: the next one is a constant away
+template <class Lanes>
+static void LatticeHashes(typename Lanes::F cell, unsigned int prime, typename Lanes::I* first, typename Lanes::I* second)
+{
+	typedef Lanes L;
+	*first = L::MulInt(L::ToInt(cell), L::SetInt(prime));
+	*second = L::AddInt(*first, L::SetInt(prime));
+}
+
+// 2D gradient noise, about (-1, 1)
+template <class Lanes>
+static typename Lanes::F GradientNoise(typename Lanes::F x, typename Lanes::F y, unsigned int seed)
+{
+	typedef Lanes L;
+	typename L::F cellX = L::Floor(x);
+	typename L::F cellY = L::Floor(y);
+	typename L::F dx = L::Sub(x, cellX);
+	typename L::F dy = L::Sub(y, cellY);
+	typename L::F dx1 = L::Sub(dx, L::Set(1.0f));
+	typename L::F dy1 = L::Sub(dy, L::Set(1.0f));
+
+	typename L::I x0, x1, y0, y1;
+	LatticeHashes<Lanes>(cellX, NOISE_PRIME_X, &x0, &x1);
+	LatticeHashes<Lanes>(cellY, NOISE_PRIME_Y, &y0, &y1);
+	y0 = L::Xor(y0, L::SetInt(seed));
+	y1 = L::Xor(y1, L::SetInt(seed));
+
+	typename L::F n00 = CornerDot<Lanes>(x0, y0, dx, dy);
+	typename L::F n10 = CornerDot<Lanes>(x1, y0, dx1, dy);
+	typename L::F n01 = CornerDot<Lanes>(x0, y1, dx, dy1);
+	typename L::F n11 = CornerDot<Lanes>(x1, y1, dx1, dy1);
+	return Blend<Lanes>(n00, n10, n01, n11, Fade<Lanes>(dx), Fade<Lanes>(dy));
+}
+
+// an octave along a row: what only depends on y, and the gradients of the lattice cell the last lanes were in
+typedef struct
+{
+	float frequency;
+	float amplitude;
+	float shift;
+	unsigned int seed;
+	float dy, dy1, v; // offsets to the lattice rows around the row and the faded offset
+	unsigned int y0, y1; // hashes of the lattice rows, seeded
+	bool cached = false;
+	float cachedCell; // lattice column of the gradients
+	float gradients[8]; // x and y of the corners 00, 10, 01 and 11
+} NoiseOctaveRow;
+
+// the octaves of a fractal sum at the coordinate y of a row, same frequencies, amplitudes, shifts and seeds as FractalSum
+static int PrepareOctaves(NoiseOctaveRow* octaves, float y, unsigned int seed, int count, const NoiseParameters& noise)
+{
+	typedef NoiseLanesScalar L;
+	count = std::min(count, NOISE_MAX_OCTAVES);
+	float frequency = 1.0f;
+	float amplitude = 1.0f;
+	for (int octave = 0; octave < count; octave++)
+	{
+		NoiseOctaveRow& row = octaves[octave];
+		row.frequency = frequency;
+		row.amplitude = amplitude;
+		row.shift = octave * NOISE_OCTAVE_SHIFT;
+		row.seed = seed + octave * NOISE_OCTAVE_SEED;
+		float octaveY = L::Add(L::Mul(y, frequency), row.shift);
+		float cellY = L::Floor(octaveY);
+		row.dy = L::Sub(octaveY, cellY);
+		row.dy1 = L::Sub(row.dy, 1.0f);
+		row.v = Fade<L>(row.dy);
+		LatticeHashes<L>(cellY, NOISE_PRIME_Y, &row.y0, &row.y1);
+		row.y0 ^= row.seed;
+		row.y1 ^= row.seed;
+		row.cached = false;
+		frequency *= noise.lacunarity;
+		amplitude *= noise.gain;
+	}
+	return count;
+}
+
+// GradientNoise of an octave of the row at the cells of coordinates x
+template <class Lanes>
+static typename Lanes::F OctaveNoise(typename Lanes::F x, NoiseOctaveRow* octave)
+{
+	typedef Lanes L;
+	typename L::F octaveX = L::Add(L::Mul(x, L::Set(octave->frequency)), L::Set(octave->shift));
+	typename L::F cellX = L::Floor(octaveX);
+	typename L::F dx = L::Sub(octaveX, cellX);
+	typename L::F dx1 = L::Sub(dx, L::Set(1.0f));
+	typename L::F dy = L::Set(octave->dy);
+	typename L::F dy1 = L::Set(octave->dy1);
+	typename L::F n00, n10, n01, n11;
+	float cell;
+	if (L::SameValue(cellX, &cell))
+	{
+		// the lanes share a lattice cell, its gradients are hashed once
+		float* gradients = octave->gradients;
+		if (!octave->cached || octave->cachedCell != cell)
+		{
+			unsigned int x0, x1;
+			LatticeHashes<NoiseLanesScalar>(cell, NOISE_PRIME_X, &x0, &x1);
+			CornerGradient<NoiseLanesScalar>(x0, octave->y0, &gradients[0], &gradients[1]);
+			CornerGradient<NoiseLanesScalar>(x1, octave->y0, &gradients[2], &gradients[3]);
+			CornerGradient<NoiseLanesScalar>(x0, octave->y1, &gradients[4], &gradients[5]);
+			CornerGradient<NoiseLanesScalar>(x1, octave->y1, &gradients[6], &gradients[7]);
+			octave->cached = true;
+			octave->cachedCell = cell;
+		}
+		n00 = CornerDot<Lanes>(L::Set(gradients[0]), L::Set(gradients[1]), dx, dy);
+		n10 = CornerDot<Lanes>(L::Set(gradients[2]), L::Set(gradients[3]), dx1, dy);
+		n01 = CornerDot<Lanes>(L::Set(gradients[4]), L::Set(gradients[5]), dx, dy1);
+		n11 = CornerDot<Lanes>(L::Set(gradients[6]), L::Set(gradients[7]), dx1, dy1);
+	}
+	else
+	{
+		typename L::I x0, x1;
+		LatticeHashes<Lanes>(cellX, NOISE_PRIME_X, &x0, &x1);
+		n00 = CornerDot<Lanes>(x0, L::SetInt(octave->y0), dx, dy);
+		n10 = CornerDot<Lanes>(x1, L::SetInt(octave->y0), dx1, dy);
+		n01 = CornerDot<Lanes>(x0, L::SetInt(octave->y1), dx, dy1);
+		n11 = CornerDot<Lanes>(x1, L::SetInt(octave->y1), dx1, dy1);
+	}
+	return Blend<Lanes>(n00, n10, n01, n11, Fade<Lanes>(dx), L::Set(octave->v));
+}
+
+// sum of octaves of gradient noise, the first one of amplitude 1
+template <class Lanes>
+static typename Lanes::F FractalSum(typename Lanes::F x, typename Lanes::F y, unsigned int seed, int octaves, const NoiseParameters& noise)
+{
+	typedef Lanes L;
+	typename L::F sum = L::Set(0.0f);
+	float frequency = 1.0f;
+	float amplitude = 1.0f;
+	for (int octave = 0; octave < std::min(octaves, NOISE_MAX_OCTAVES); octave++)
+	{
+		typename L::F shift = L::Set(octave * NOISE_OCTAVE_SHIFT);
+		typename L::F value = GradientNoise<Lanes>(L::Add(L::Mul(x, L::Set(frequency)), shift), L::Add(L::Mul(y, L::Set(frequency)), shift), seed + octave * NOISE_OCTAVE_SEED);
+		sum = L::Add(sum, L::Mul(value, L::Set(amplitude)));
+		frequency *= noise.lacunarity;
+		amplitude *= noise.gain;
+	}
+	return sum;
+}
+
+// FractalSum along a row
+template <class Lanes>
+static typename Lanes::F FractalRow(typename Lanes::F x, NoiseOctaveRow* octaves, int count)
+{
+	typedef Lanes L;
+	typename L::F sum = L::Set(0.0f);
+	for (int octave = 0; octave < count; octave++)
+	{
+		sum = L::Add(sum, L::Mul(OctaveNoise<Lanes>(x, &octaves[octave]), L::Set(octaves[octave].amplitude)));
+	}
+	return sum;
+}
+
+// Musgrave's ridged multifractal: creases where the noise crosses zero, each octave weighted by the ridges of the
+// coarser ones so valleys stay smooth
+template <class Lanes>
+static void AddRidge(typename Lanes::F value, float amplitude, typename Lanes::F* sum, typename Lanes::F* weight)
+{
+	typedef Lanes L;
+	typename L::F ridge = L::Sub(L::Set(1.0f), L::Abs(value));
+	ridge = L::Mul(L::Mul(ridge, ridge), *weight);
+	*weight = L::Min(L::Max(L::Mul(ridge, L::Set(NOISE_RIDGE_SHARPNESS)), L::Set(0.0f)), L::Set(1.0f));
+	*sum = L::Add(*sum, L::Mul(ridge, L::Set(amplitude)));
+}
+
+// ridges summed over the octaves, normalized by the sum of the amplitudes: in (0, 1)
+template <class Lanes>
+static typename Lanes::F RidgedSum(typename Lanes::F x, typename Lanes::F y, const NoiseParameters& noise)
+{
+	typedef Lanes L;
+	typename L::F sum = L::Set(0.0f);
+	typename L::F weight = L::Set(1.0f);
+	float frequency = 1.0f;
+	float amplitude = 1.0f;
+	float totalAmplitude = 0.0f;
+	for (int octave = 0; octave < std::min(noise.octaves, NOISE_MAX_OCTAVES); octave++)
+	{
+		typename L::F shift = L::Set(octave * NOISE_OCTAVE_SHIFT);
+		typename L::F value = GradientNoise<Lanes>(L::Add(L::Mul(x, L::Set(frequency)), shift), L::Add(L::Mul(y, L::Set(frequency)), shift), noise.seed + octave * NOISE_OCTAVE_SEED);
+		AddRidge<Lanes>(value, amplitude, &sum, &weight);
+		totalAmplitude += amplitude;
+		frequency *= noise.lacunarity;
+		amplitude *= noise.gain;
+	}
+	return L::Div(sum, L::Set(std::max(totalAmplitude, 1e-6f)));
+}
+
+// RidgedSum along a row
+template <class Lanes>
+static typename Lanes::F RidgedRow(typename Lanes::F x, NoiseOctaveRow* octaves, int count)
+{
+	typedef Lanes L;
+	typename L::F sum = L::Set(0.0f);
+	typename L::F weight = L::Set(1.0f);
+	float totalAmplitude = 0.0f;
+	for (int octave = 0; octave < count; octave++)
+	{
+		AddRidge<Lanes>(OctaveNoise<Lanes>(x, &octaves[octave]), octaves[octave].amplitude, &sum, &weight);
+		totalAmplitude += octaves[octave].amplitude;
+	}
+	return L::Div(sum, L::Set(std::max(totalAmplitude, 1e-6f)));
+}
+
+// fractal sum to a height in (0, 1), (sum + 1) / 2 like GenImagePerlinNoise
+template <class Lanes>
+static typename Lanes::F FractalHeight(typename Lanes::F value)
+{
+	typedef Lanes L;
+	typename L::F height = L::Mul(L::Add(L::Mul(value, L::Set(NOISE_FBM_CONTRAST)), L::Set(1.0f)), L::Set(0.5f));
+	return L::Min(L::Max(height, L::Set(0.0f)), L::Set(1.0f)); // the octaves rarely add up past the range
+}
+
+// coordinates of GenImagePerlinNoise: the map spans scale periods of the base octave
+template <class Lanes>
+static typename Lanes::F NoiseCoordinateX(int x, int mapWidth, const NoiseParameters& noise)
+{
+	typedef Lanes L;
+	return L::Div(L::Mul(L::Add(L::Columns(x), L::Set(noise.offsetX)), L::Set(noise.scale)), L::Set((float)mapWidth));
+}
+
+static float NoiseCoordinateY(int y, int mapHeight, const NoiseParameters& noise)
+{
+	return ((float)y + noise.offsetY) * noise.scale / (float)mapHeight;
+}
+
+// noise of the cells starting at column x of a row, in (0, 1), evaluated cell by cell
+template <class Lanes>
+static typename Lanes::F NoiseCells(int x, int y, int mapWidth, int mapHeight, const NoiseParameters& noise)
+{
+	typedef Lanes L;
+	typename L::F nx = NoiseCoordinateX<Lanes>(x, mapWidth, noise);
+	typename L::F ny = L::Set(NoiseCoordinateY(y, mapHeight, noise));
+	switch (noise.type)
+	{
+	case NoiseType::RIDGED:
+		return RidgedSum<Lanes>(nx, ny, noise);
+	case NoiseType::DOMAIN_WARPED:
+	{
+		// fBm of the coordinates moved by two coarser fBm fields
+		typename L::F warpX = FractalSum<Lanes>(nx, ny, noise.seed + 1, noise.warpOctaves, noise);
+		typename L::F warpY = FractalSum<Lanes>(L::Add(nx, L::Set(NOISE_WARP_SHIFT_X)), L::Add(ny, L::Set(NOISE_WARP_SHIFT_Y)), noise.seed + 2, noise.warpOctaves, noise);
+		typename L::F strength = L::Set(noise.warpStrength);
+		return FractalHeight<Lanes>(FractalSum<Lanes>(L::Add(nx, L::Mul(warpX, strength)), L::Add(ny, L::Mul(warpY, strength)), noise.seed, noise.octaves, noise));
+	}
+	default:
+		return FractalHeight<Lanes>(FractalSum<Lanes>(nx, ny, noise.seed, noise.octaves, noise));
+	}
+}
+
+// the octaves of a row of the map
+typedef struct
+{
+	float y;
+	int count, warpCount;
+	NoiseOctaveRow octaves[NOISE_MAX_OCTAVES];
+	NoiseOctaveRow warpX[NOISE_MAX_OCTAVES];
+	NoiseOctaveRow warpY[NOISE_MAX_OCTAVES];
+} NoiseRow;
+
+static void PrepareRow(NoiseRow* row, int y, int mapHeight, const NoiseParameters& noise)
+{
+	row->y = NoiseCoordinateY(y, mapHeight, noise);
+	row->count = PrepareOctaves(row->octaves, row->y, noise.seed, noise.octaves, noise);
+	if (noise.type == NoiseType::DOMAIN_WARPED)
+	{
+		row->warpCount = PrepareOctaves(row->warpX, row->y, noise.seed + 1, noise.warpOctaves, noise);
+		PrepareOctaves(row->warpY, row->y + NOISE_WARP_SHIFT_Y, noise.seed + 2, noise.warpOctaves, noise);
+	}
+}
+
+// NoiseCells with the octaves of the row
+template <class Lanes>
+static typename Lanes::F NoiseRowCells(int x, int mapWidth, NoiseRow* row, const NoiseParameters& noise)
+{
+	typedef Lanes L;
+	typename L::F nx = NoiseCoordinateX<Lanes>(x, mapWidth, noise);
+	switch (noise.type)
+	{
+	case NoiseType::RIDGED:
+		return RidgedRow<Lanes>(nx, row->octaves, row->count);
+	case NoiseType::DOMAIN_WARPED:
+	{
+		// the warp fields are sampled along the row, the warped coordinates leave it
+		typename L::F warpX = FractalRow<Lanes>(nx, row->warpX, row->warpCount);
+		typename L::F warpY = FractalRow<Lanes>(L::Add(nx, L::Set(NOISE_WARP_SHIFT_X)), row->warpY, row->warpCount);
+		typename L::F strength = L::Set(noise.warpStrength);
+		return FractalHeight<Lanes>(FractalSum<Lanes>(L::Add(nx, L::Mul(warpX, strength)), L::Add(L::Set(row->y), L::Mul(warpY, strength)), noise.seed, noise.octaves, noise));
+	}
+	default:
+		return FractalHeight<Lanes>(FractalRow<Lanes>(nx, row->octaves, row->count));
+	}
+}
+
+void ErosionMaker::GenerateNoise(float* heights, int mapWidth, int mapHeight, const NoiseParameters& noise)
+{
+	int threads = (parameters.threadCount <= 0) ? ThreadPool::GetHardwareThreadCount() : parameters.threadCount;
+	ThreadPool::GetInstance().ParallelForRows(mapHeight, NOISE_ROWS_PER_TASK, threads, [&](int firstRow, int lastRow)
+	{
+		NoiseRow row;
+		for (int y = firstRow; y < lastRow; y++)
+		{
+			PrepareRow(&row, y, mapHeight, noise);
+			float* rowHeights = heights + (size_t)y * mapWidth;
+			int x = 0;
+#ifdef NOISE_SSE2
+			for (; x + NoiseLanesSse2::WIDTH <= mapWidth; x += NoiseLanesSse2::WIDTH)
+			{
+				NoiseLanesSse2::Store(rowHeights + x, NoiseRowCells<NoiseLanesSse2>(x, mapWidth, &row, noise));
+			}
+#endif
+			for (; x < mapWidth; x++)
+			{
+				rowHeights[x] = NoiseRowCells<NoiseLanesScalar>(x, mapWidth, &row, noise);
+			}
+		}
+	});
+}
+
+float ErosionMaker::SampleNoise(int x, int y, int mapWidth, int mapHeight, const NoiseParameters& noise)
+{
+	return NoiseCells<NoiseLanesScalar>(x, y, mapWidth, mapHeight, noise);
+}
@@ -0,0 +1,124 @@
+#include "ErosionMakerPacket.h"
+#include <climits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// instruction sets usable on this CPU (compiled in and supported by CPU and OS)
+#ifdef EROSION_PACKET_AVX2
+static bool CpuSupportsAvx2();
+#endif
+#ifdef EROSION_PACKET_AVX512
+static bool CpuSupportsAvx512();
+#endif
+
+const char* ErosionMaker::GetPacketInstructionSet()
+{
+#ifdef EROSION_PACKET_AVX512
+	if (CpuSupportsAvx512())
+		return "AVX-512";
+#endif
+#ifdef EROSION_PACKET_AVX2
+	if (CpuSupportsAvx2())
+		return "AVX2";
+#endif
+	return "none (scalar)";
+}
+
+bool ErosionMaker::HasPacketKernel()
+{
+#ifdef EROSION_PACKET_AVX512
+	if (CpuSupportsAvx512())
+		return true;
+#endif
+#ifdef EROSION_PACKET_AVX2
+	if (CpuSupportsAvx2())
+		return true;
+#endif
+	return false;
+}
+
+void ErosionMaker::SimulateDropletPackets(std::vector<float>* mapData, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics)
+{
+#if defined(EROSION_PACKET_AVX2) || defined(EROSION_PACKET_AVX512)
+	// lanes address cells with 32-bit gather indices, larger maps run the scalar kernel
+	bool fitsLaneIndex = (size_t)mapWidth * mapHeight <= (size_t)INT_MAX;
+#endif
+#ifdef EROSION_PACKET_AVX512
+	static const bool useAvx512 = CpuSupportsAvx512();
+	if (useAvx512 && fitsLaneIndex)
+	{
+		SimulateDropletPacketsAvx512(this, mapData, mapWidth, mapHeight, spawns, count, dirty, statistics);
+		return;
+	}
+#endif
+#ifdef EROSION_PACKET_AVX2
+	static const bool useAvx2 = CpuSupportsAvx2();
+	if (useAvx2 && fitsLaneIndex)
+	{
+		SimulateDropletPacketsAvx2(this, mapData, mapWidth, mapHeight, spawns, count, dirty, statistics);
+		return;
+	}
+#endif
+	for (int i = 0; i < count; i++)
+	{
+		SimulateDroplet(mapData, mapWidth, mapHeight, spawns[i].x, spawns[i].y, dirty, statistics);
+	}
+}
+
+#if defined(EROSION_PACKET_AVX2) || defined(EROSION_PACKET_AVX512)
+// queries CPUID and XGETBV: the CPU must support the instructions and the OS must save the wide registers
+static void Cpuid(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, leaf, subleaf);
+	for (int i = 0; i < 4; i++) regs[i] = (unsigned int)info[i];
+#else
+	__asm__ __volatile__("cpuid" : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3]) : "a"(leaf), "c"(subleaf));
+#endif
+}
+
+static unsigned long long EnabledRegisterState()
+{
+	unsigned int regs[4];
+	Cpuid(1, 0, regs);
+	if (!(regs[2] & (1u << 27))) // OSXSAVE
+		return 0;
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int low, high;
+	__asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((unsigned long long)high << 32) | low;
+#endif
+}
+
+#ifdef EROSION_PACKET_AVX2
+static bool CpuSupportsAvx2()
+{
+	unsigned int regs[4];
+	Cpuid(0, 0, regs);
+	if (regs[0] < 7)
+		return false;
+	if ((EnabledRegisterState() & 0x6) != 0x6) // XMM and YMM state
+		return false;
+	Cpuid(7, 0, regs);
+	return (regs[1] & (1u << 5)) != 0; // AVX2
+}
+#endif
+
+#ifdef EROSION_PACKET_AVX512
+static bool CpuSupportsAvx512()
+{
+	unsigned int regs[4];
+	Cpuid(0, 0, regs);
+	if (regs[0] < 7)
+		return false;
+	if ((EnabledRegisterState() & 0xE6) != 0xE6) // XMM, YMM, opmask and ZMM state
+		return false;
+	Cpuid(7, 0, regs);
+	return (regs[1] & (1u << 16)) != 0; // AVX-512 F
+}
+#endif
+#endif
@@ -0,0 +1,27 @@
+#ifndef EROSION_MAKER_PACKET
+#define EROSION_MAKER_PACKET
+
+#include <vector>
+#include "ErosionMaker.h"
+
+// packet kernel: a group of droplets (one per SIMD lane) is advanced in lockstep.
+// height sampling, direction, speed and water updates run on all lanes at once using gathers for the cell corners,
+// while writes to the map are applied lane after lane so droplets of a packet touching the same cells never conflict.
+// lanes whose droplet died are refilled with the next droplet, so the packet stays full until the batch is over.
+// the kernel (ErosionMakerPacketKernel.h) is written once against a "Lanes" interface and instantiated for every
+// instruction set in a file of its own (ErosionMakerPacketAvx2.cpp, ErosionMakerPacketAvx512.cpp), ErosionMakerPacket.cpp
+// picks the widest one the CPU supports at runtime, CPUs without any of them run the scalar kernel instead.
+
+// instruction sets the kernel is compiled for on this compiler. MSVC exposes every intrinsic regardless of /arch, gcc and
+// clang compile the functions of an instruction set file for its target whatever the command line, so a portable build
+// still has every kernel for the runtime dispatch
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#define EROSION_PACKET_AVX2
+#define EROSION_PACKET_AVX512
+#endif
+
+// entry points of the instruction set files, called by the dispatch only on CPUs that support them
+void SimulateDropletPacketsAvx2(ErosionMaker* maker, std::vector<float>* map, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics);
+void SimulateDropletPacketsAvx512(ErosionMaker* maker, std::vector<float>* map, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics);
+
+#endif
@@ -0,0 +1,84 @@
+#include "ErosionMakerPacket.h"
+#include <algorithm>
+
+#ifdef EROSION_PACKET_AVX2
+#include <immintrin.h>
+
+// the target is enabled after the library headers so only the lanes and the kernel are compiled for it
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+// lanes of 8 droplets in the 256 bit registers of AVX2
+struct LanesAvx2
+{
+	static const int WIDTH = 8;
+
+	typedef __m256 F;
+	typedef __m256i I;
+	typedef __m256 M; // all bits set on true lanes
+
+	static __m256i PartialMask(int n) { return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+
+	static F Set(float a) { return _mm256_set1_ps(a); }
+	static F Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, F a) { _mm256_storeu_ps(p, a); }
+	static F LoadPartial(const float* p, int n) { return _mm256_maskload_ps(p, PartialMask(n)); }
+	static void StorePartial(float* p, F a, int n) { _mm256_maskstore_ps(p, PartialMask(n), a); }
+	static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+	static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+	static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+	static F Sqrt(F a) { return _mm256_sqrt_ps(a); }
+	static float Sum(F a)
+	{
+		__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+		s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+		s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+		return _mm_cvtss_f32(s);
+	}
+
+	static I Truncate(F a) { return _mm256_cvttps_epi32(a); }
+	static F ToFloat(I a) { return _mm256_cvtepi32_ps(a); }
+	static I CellIndex(I x, I y, int mapWidth) { return _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(mapWidth)), x); }
+	static F Gather(const float* base, I index, int offset) { return _mm256_i32gather_ps(base + offset, index, 4); }
+	static void StoreInt(int* p, I a) { _mm256_storeu_si256((__m256i*)p, a); }
+
+	static M Less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static M Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static M GreaterEqual(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static M Equal(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static M And(M a, M b) { return _mm256_and_ps(a, b); }
+	static M Or(M a, M b) { return _mm256_or_ps(a, b); }
+	static M AndNot(M a, M b) { return _mm256_andnot_ps(b, a); } // a and not b
+	static M FromBits(unsigned int bits)
+	{
+		__m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+		return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)bits), laneBits), laneBits));
+	}
+	static unsigned int ToBits(M m) { return (unsigned int)_mm256_movemask_ps(m); }
+	static F Select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+	static I SelectInt(M m, I a, I b) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m)); }
+	static I ZeroInt() { return _mm256_setzero_si256(); }
+};
+
+#include "ErosionMakerPacketKernel.h"
+
+template class DropletPackets<LanesAvx2>;
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+void SimulateDropletPacketsAvx2(ErosionMaker* maker, std::vector<float>* map, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics)
+{
+	DropletPackets<LanesAvx2>::Simulate(maker, map, mapWidth, mapHeight, spawns, count, dirty, statistics);
+}
+#endif
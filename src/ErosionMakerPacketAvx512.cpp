@@ -0,0 +1,79 @@
+#include "ErosionMakerPacket.h"
+#include <algorithm>
+
+#ifdef EROSION_PACKET_AVX512
+#if defined(__GNUC__) && !defined(__clang__)
+// the intrinsics of gcc 12 start their results from the _mm*_undefined_* values, which the warnings take for reads
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+
+// the target is enabled after the library headers so only the lanes and the kernel are compiled for it
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+// lanes of 16 droplets in the 512 bit registers of AVX-512, the comparisons give opmasks
+struct LanesAvx512
+{
+	static const int WIDTH = 16;
+
+	typedef __m512 F;
+	typedef __m512i I;
+	typedef __mmask16 M;
+
+	static __mmask16 PartialMask(int n) { return (__mmask16)((1u << n) - 1); }
+
+	static F Set(float a) { return _mm512_set1_ps(a); }
+	static F Load(const float* p) { return _mm512_loadu_ps(p); }
+	static void Store(float* p, F a) { _mm512_storeu_ps(p, a); }
+	static F LoadPartial(const float* p, int n) { return _mm512_maskz_loadu_ps(PartialMask(n), p); }
+	static void StorePartial(float* p, F a, int n) { _mm512_mask_storeu_ps(p, PartialMask(n), a); }
+	static F Add(F a, F b) { return _mm512_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm512_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm512_mul_ps(a, b); }
+	static F Div(F a, F b) { return _mm512_div_ps(a, b); }
+	static F Min(F a, F b) { return _mm512_min_ps(a, b); }
+	static F Max(F a, F b) { return _mm512_max_ps(a, b); }
+	static F Sqrt(F a) { return _mm512_sqrt_ps(a); }
+	static float Sum(F a) { return _mm512_reduce_add_ps(a); }
+
+	static I Truncate(F a) { return _mm512_cvttps_epi32(a); }
+	static F ToFloat(I a) { return _mm512_cvtepi32_ps(a); }
+	static I CellIndex(I x, I y, int mapWidth) { return _mm512_add_epi32(_mm512_mullo_epi32(y, _mm512_set1_epi32(mapWidth)), x); }
+	static F Gather(const float* base, I index, int offset) { return _mm512_i32gather_ps(index, base + offset, 4); }
+	static void StoreInt(int* p, I a) { _mm512_storeu_si512(p, a); }
+
+	static M Less(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static M Greater(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+	static M GreaterEqual(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+	static M Equal(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+	static M And(M a, M b) { return (M)(a & b); }
+	static M Or(M a, M b) { return (M)(a | b); }
+	static M AndNot(M a, M b) { return (M)(a & ~b); } // a and not b
+	static M FromBits(unsigned int bits) { return (M)bits; }
+	static unsigned int ToBits(M m) { return (unsigned int)m; }
+	static F Select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+	static I SelectInt(M m, I a, I b) { return _mm512_mask_blend_epi32(m, b, a); }
+	static I ZeroInt() { return _mm512_setzero_si512(); }
+};
+
+#include "ErosionMakerPacketKernel.h"
+
+template class DropletPackets<LanesAvx512>;
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+void SimulateDropletPacketsAvx512(ErosionMaker* maker, std::vector<float>* map, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics)
+{
+	DropletPackets<LanesAvx512>::Simulate(maker, map, mapWidth, mapHeight, spawns, count, dirty, statistics);
+}
+#endif
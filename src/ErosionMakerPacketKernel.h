@@ -0,0 +1,250 @@
+#ifndef EROSION_MAKER_PACKET_KERNEL
+#define EROSION_MAKER_PACKET_KERNEL
+
+#include <algorithm>
+#include "ErosionMakerPacket.h"
+
+// the kernel for the lanes of an instruction set. only the instruction set files include this header, after enabling
+// their target: gcc and clang compile a template for the target in effect where it is defined, not where it is instantiated
+template <class Lanes>
+class DropletPackets
+{
+public:
+	static void Simulate(ErosionMaker* maker, std::vector<float>* map, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics);
+
+private:
+	static void ErodeWithBrushRows(const ErosionBrush* brush, float* heights, float amountToErode, float& sediment);
+#if EROSION_STATISTICS
+	static int PopCount(unsigned int bits); // number of set bits, only used by the statistics
+#endif
+};
+
+#if EROSION_STATISTICS
+template <class Lanes>
+int DropletPackets<Lanes>::PopCount(unsigned int bits)
+{
+	int count = 0;
+	for (; bits != 0; bits &= bits - 1)
+		count++;
+	return count;
+}
+#endif
+
+template <class Lanes>
+void DropletPackets<Lanes>::Simulate(ErosionMaker* maker, std::vector<float>* mapData, int mapWidth, int mapHeight, const Vector2* spawns, int count, unsigned long long* dirty, DropletStatistics* statistics)
+{
+	typedef typename Lanes::F F;
+	typedef typename Lanes::I I;
+	typedef typename Lanes::M M;
+	const int W = Lanes::WIDTH;
+	const ErosionParameters& job = maker->job;
+	const ErosionBrush* brush = maker->brush.get();
+
+	// droplet state, one droplet per lane
+	float posX[W], posY[W], dirX[W], dirY[W], speed[W], water[W], sediment[W];
+	int lifetime[W]; // -1 = lane is free
+
+	// values computed in lockstep and consumed by the per-lane map updates
+	int cellIndex[W];
+	float cellOffsetX[W], cellOffsetY[W], amountToDeposit[W], amountToErode[W];
+
+	for (int lane = 0; lane < W; lane++)
+	{
+		lifetime[lane] = -1;
+		posX[lane] = posY[lane] = dirX[lane] = dirY[lane] = speed[lane] = water[lane] = sediment[lane] = 0;
+	}
+
+	float* heights = mapData->data();
+	const F zero = Lanes::Set(0.0f);
+	const F one = Lanes::Set(1.0f);
+	const F inertiaV = Lanes::Set(job.inertia);
+	const F notInertia = Lanes::Set(1 - job.inertia);
+	const F lastColumn = Lanes::Set((float)(mapWidth - 1));
+	const F lastRow = Lanes::Set((float)(mapHeight - 1));
+	int nextDroplet = 0;
+
+	while (true)
+	{
+		// refill free lanes with the next droplets, in order
+		unsigned int activeBits = 0;
+		for (int lane = 0; lane < W; lane++)
+		{
+			if (lifetime[lane] < 0 && nextDroplet < count)
+			{
+				posX[lane] = spawns[nextDroplet].x;
+				posY[lane] = spawns[nextDroplet].y;
+				dirX[lane] = dirY[lane] = 0;
+				speed[lane] = job.initialSpeed;
+				water[lane] = job.initialWaterVolume;
+				sediment[lane] = 0;
+				lifetime[lane] = 0;
+				nextDroplet++;
+			}
+			if (lifetime[lane] >= 0)
+				activeBits |= 1u << lane;
+		}
+		if (activeBits == 0)
+			break;
+		M active = Lanes::FromBits(activeBits);
+
+		F px = Lanes::Load(posX);
+		F py = Lanes::Load(posY);
+
+		// droplet position bound to cell, free lanes read cell 0 so gathers stay inside the map
+		I nodeX = Lanes::Truncate(px);
+		I nodeY = Lanes::Truncate(py);
+		I index = Lanes::SelectInt(active, Lanes::CellIndex(nodeX, nodeY, mapWidth), Lanes::ZeroInt());
+		F offX = Lanes::Sub(px, Lanes::ToFloat(nodeX));
+		F offY = Lanes::Sub(py, Lanes::ToFloat(nodeY));
+
+		// height and gradient with bilinear interpolation of the four nodes of the cell
+		F heightNW = Lanes::Gather(heights, index, 0);
+		F heightNE = Lanes::Gather(heights, index, 1);
+		F heightSW = Lanes::Gather(heights, index, mapWidth);
+		F heightSE = Lanes::Gather(heights, index, mapWidth + 1);
+		F invX = Lanes::Sub(one, offX);
+		F invY = Lanes::Sub(one, offY);
+		F gradientX = Lanes::Add(Lanes::Mul(Lanes::Sub(heightNE, heightNW), invY), Lanes::Mul(Lanes::Sub(heightSE, heightSW), offY));
+		F gradientY = Lanes::Add(Lanes::Mul(Lanes::Sub(heightSW, heightNW), invX), Lanes::Mul(Lanes::Sub(heightSE, heightNE), offX));
+		F height = Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Mul(heightNW, invX), invY), Lanes::Mul(Lanes::Mul(heightNE, offX), invY)),
+			Lanes::Add(Lanes::Mul(Lanes::Mul(heightSW, invX), offY), Lanes::Mul(Lanes::Mul(heightSE, offX), offY)));
+
+		// update direction (lerp with old direction by inertia) and normalize it
+		F dx = Lanes::Sub(Lanes::Mul(Lanes::Load(dirX), inertiaV), Lanes::Mul(gradientX, notInertia));
+		F dy = Lanes::Sub(Lanes::Mul(Lanes::Load(dirY), inertiaV), Lanes::Mul(gradientY, notInertia));
+		F len = Lanes::Sqrt(Lanes::Add(Lanes::Mul(dx, dx), Lanes::Mul(dy, dy)));
+		M normalize = Lanes::Greater(len, Lanes::Set(0.0001f));
+		dx = Lanes::Select(normalize, Lanes::Div(dx, len), dx);
+		dy = Lanes::Select(normalize, Lanes::Div(dy, len), dy);
+		px = Lanes::Add(px, dx);
+		py = Lanes::Add(py, dy);
+
+		// stop droplets that are not moving or flowed over the edge of the map
+		M stopped = Lanes::And(Lanes::Equal(dx, zero), Lanes::Equal(dy, zero));
+		stopped = Lanes::Or(stopped, Lanes::Or(Lanes::Less(px, zero), Lanes::GreaterEqual(px, lastColumn)));
+		stopped = Lanes::Or(stopped, Lanes::Or(Lanes::Less(py, zero), Lanes::GreaterEqual(py, lastRow)));
+		M alive = Lanes::AndNot(active, stopped);
+		unsigned int aliveBits = Lanes::ToBits(alive);
+
+		// height at the new position (bilinear)
+		I newNodeX = Lanes::Truncate(px);
+		I newNodeY = Lanes::Truncate(py);
+		I newIndex = Lanes::SelectInt(alive, Lanes::CellIndex(newNodeX, newNodeY, mapWidth), Lanes::ZeroInt());
+		F newOffX = Lanes::Sub(px, Lanes::ToFloat(newNodeX));
+		F newOffY = Lanes::Sub(py, Lanes::ToFloat(newNodeY));
+		F newInvX = Lanes::Sub(one, newOffX);
+		F newInvY = Lanes::Sub(one, newOffY);
+		F newHeight = Lanes::Add(
+			Lanes::Add(Lanes::Mul(Lanes::Mul(Lanes::Gather(heights, newIndex, 0), newInvX), newInvY), Lanes::Mul(Lanes::Mul(Lanes::Gather(heights, newIndex, 1), newOffX), newInvY)),
+			Lanes::Add(Lanes::Mul(Lanes::Mul(Lanes::Gather(heights, newIndex, mapWidth), newInvX), newOffY), Lanes::Mul(Lanes::Mul(Lanes::Gather(heights, newIndex, mapWidth + 1), newOffX), newOffY)));
+		F dh = Lanes::Sub(newHeight, height);
+
+		// sediment capacity and how much to deposit or erode
+		F sp = Lanes::Load(speed);
+		F wt = Lanes::Load(water);
+		F sd = Lanes::Load(sediment);
+		F capacity = Lanes::Max(Lanes::Mul(Lanes::Mul(Lanes::Mul(Lanes::Sub(zero, dh), sp), wt), Lanes::Set(job.sedimentCapacityFactor)), Lanes::Set(job.minSedimentCapacity));
+		M uphill = Lanes::Greater(dh, zero);
+		M deposit = Lanes::Or(Lanes::Greater(sd, capacity), uphill);
+		F toDeposit = Lanes::Select(uphill, Lanes::Min(dh, sd), Lanes::Mul(Lanes::Sub(sd, capacity), Lanes::Set(job.depositSpeed)));
+		F toErode = Lanes::Min(Lanes::Mul(Lanes::Sub(capacity, sd), Lanes::Set(job.erodeSpeed)), Lanes::Sub(zero, dh));
+		toDeposit = Lanes::Select(deposit, toDeposit, zero);
+		sd = Lanes::Sub(sd, toDeposit);
+		unsigned int depositBits = Lanes::ToBits(deposit);
+
+		// speed and water content
+		sp = Lanes::Sqrt(Lanes::Add(Lanes::Mul(sp, sp), Lanes::Mul(dh, Lanes::Set(job.gravity))));
+		M validSpeed = Lanes::Equal(sp, sp);
+		sp = Lanes::Select(validSpeed, sp, zero); // NaN when speed * speed + deltaHeight * gravity is negative
+		wt = Lanes::Mul(wt, Lanes::Set(1 - job.evaporateSpeed));
+
+		Lanes::Store(posX, px);
+		Lanes::Store(posY, py);
+		Lanes::Store(dirX, dx);
+		Lanes::Store(dirY, dy);
+		Lanes::Store(speed, sp);
+		Lanes::Store(water, wt);
+		Lanes::Store(sediment, sd);
+		Lanes::StoreInt(cellIndex, index);
+		Lanes::Store(cellOffsetX, offX);
+		Lanes::Store(cellOffsetY, offY);
+		Lanes::Store(amountToDeposit, toDeposit);
+		Lanes::Store(amountToErode, toErode);
+
+		DROPLET_STATISTICS(if (statistics != nullptr) statistics->nanSpeeds += PopCount(aliveBits & ~Lanes::ToBits(validSpeed)));
+
+		// apply map updates one lane at a time (lanes may touch the same cells)
+		for (int lane = 0; lane < W; lane++)
+		{
+			if (!(activeBits & (1u << lane)))
+				continue;
+			if (!(aliveBits & (1u << lane)))
+			{
+				DROPLET_STATISTICS(if (statistics != nullptr) ErosionMaker::RecordDroplet(statistics, lifetime[lane], (dirX[lane] == 0 && dirY[lane] == 0) ? DropletEnd::STALLED : DropletEnd::EDGE));
+				lifetime[lane] = -1;
+				continue;
+			}
+
+			size_t dropletIndex = (size_t)cellIndex[lane];
+			int nodeX = (int)(dropletIndex % mapWidth);
+			int nodeY = (int)(dropletIndex / mapWidth);
+			maker->MarkDirtyNode(dirty, mapWidth, mapHeight, nodeX, nodeY);
+			if (depositBits & (1u << lane))
+			{
+				// DEPOSIT: add the sediment to the four nodes of the current cell using bilinear interpolation
+				float amount = amountToDeposit[lane];
+				float x = cellOffsetX[lane];
+				float y = cellOffsetY[lane];
+				heights[dropletIndex] += amount * (1 - x) * (1 - y);
+				heights[dropletIndex + 1] += amount * x * (1 - y);
+				heights[dropletIndex + mapWidth] += amount * (1 - x) * y;
+				heights[dropletIndex + mapWidth + 1] += amount * x * y;
+				DROPLET_STATISTICS(if (statistics != nullptr) { statistics->depositSteps++; statistics->deposited += amount; });
+			}
+			else
+			{
+				// ERODE: use erosion brush to erode from all nodes inside the droplet's erosion radius
+				DROPLET_STATISTICS(float carried = sediment[lane]);
+				if (nodeX >= brush->radius && nodeX < mapWidth - brush->radius && nodeY >= brush->radius && nodeY < mapHeight - brush->radius)
+					ErodeWithBrushRows(brush, heights + dropletIndex, amountToErode[lane], sediment[lane]);
+				else
+					maker->ErodeWithBrush(mapData->data(), RowMajorLayout(mapWidth), mapWidth, mapHeight, nodeX, nodeY, amountToErode[lane], sediment[lane]);
+				DROPLET_STATISTICS(if (statistics != nullptr) { statistics->erodeSteps++; statistics->eroded += sediment[lane] - carried; });
+			}
+
+			lifetime[lane]++;
+			if (lifetime[lane] >= job.maxDropletLifetime)
+			{
+				DROPLET_STATISTICS(if (statistics != nullptr) ErosionMaker::RecordDroplet(statistics, lifetime[lane], DropletEnd::LIFETIME));
+				lifetime[lane] = -1;
+			}
+		}
+	}
+}
+
+// erodes the full brush around a cell one row at a time with vector loads and stores
+template <class Lanes>
+void DropletPackets<Lanes>::ErodeWithBrushRows(const ErosionBrush* brush, float* heights, float amountToErode, float& sediment)
+{
+	typedef typename Lanes::F F;
+	const int W = Lanes::WIDTH;
+
+	F amount = Lanes::Set(amountToErode);
+	F eroded = Lanes::Set(0.0f);
+	for (size_t row = 0; row < brush->rows.size(); row++)
+	{
+		float* cells = heights + brush->rows[row].indexOffset;
+		const float* weights = brush->weights.data() + brush->rows[row].firstPoint;
+		for (int i = 0; i < brush->rows[row].count; i += W)
+		{
+			int n = std::min(W, brush->rows[row].count - i);
+			F height = Lanes::LoadPartial(cells + i, n);
+			F delta = Lanes::Min(height, Lanes::Mul(amount, Lanes::LoadPartial(weights + i, n))); // don't erode below zero
+			Lanes::StorePartial(cells + i, Lanes::Sub(height, delta), n);
+			eroded = Lanes::Add(eroded, delta);
+		}
+	}
+	sediment += Lanes::Sum(eroded);
+}
+
+#endif
@@ -0,0 +1,195 @@
+#include "FloatContract.h"
+#include "ErosionMaker.h"
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "ThreadPool.h"
+
+// grid erosion with the shallow water "virtual pipe" model (Mei, Decaudin, Hu - Fast Hydraulic Erosion Simulation and Visualization on GPU).
+// every cell holds water, suspended sediment and the outflow through four virtual pipes to its neighbors.
+// an iteration is a fixed sequence of passes over the whole map; each pass only writes the cell it is computing
+// (or a separate buffer), so rows can be split among threads and inner loops have a regular, branch-light stencil.
+
+static const int PIPE_ROWS_PER_TASK = 16; // rows of the map processed by a single task
+
+// runs rowTask(firstRow, lastRow) on bands of rows in parallel
+template <class RowTask>
+static void ParallelRows(int rows, int threads, const RowTask& rowTask)
+{
+	ThreadPool::GetInstance().ParallelForRows(rows, PIPE_ROWS_PER_TASK, threads, rowTask);
+}
+
+void ErosionMaker::ResetPipeState()
+{
+	pipeMapWidth = 0; // fields are reallocated and cleared on next pipe iteration
+}
+
+void ErosionMaker::ErodePipes(std::vector<float>* mapData, int mapWidth, int mapHeight, int iterations)
+{
+	size_t cells = (size_t)mapWidth * mapHeight;
+	if (pipeMapWidth != mapWidth || pipeMapHeight != mapHeight)
+	{
+		pipeWater.assign(cells, 0.0f);
+		pipeSediment.assign(cells, 0.0f);
+		pipeSedimentNext.assign(cells, 0.0f);
+		pipeTerrainNext.assign(cells, 0.0f);
+		pipeFluxLeft.assign(cells, 0.0f);
+		pipeFluxRight.assign(cells, 0.0f);
+		pipeFluxTop.assign(cells, 0.0f);
+		pipeFluxBottom.assign(cells, 0.0f);
+		pipeVelocityX.assign(cells, 0.0f);
+		pipeVelocityY.assign(cells, 0.0f);
+		pipeOutflowRatio.assign(cells, 0.0f);
+		pipeMapWidth = mapWidth;
+		pipeMapHeight = mapHeight;
+	}
+
+	int threads = (job.threadCount <= 0) ? ThreadPool::GetHardwareThreadCount() : job.threadCount;
+	const float dt = job.pipeTimeStep;
+	const float cellArea = job.pipeCellLength * job.pipeCellLength;
+	const float rain = job.pipeRainRate * dt;
+	const float fluxFactor = dt * job.pipeGravity * job.pipeCellLength; // dt * g * pipe area / pipe length, pipe area = cellLength^2
+	const float evaporation = std::max(0.0f, 1.0f - job.pipeEvaporateSpeed * dt);
+	const int width = mapWidth;
+	const int height = mapHeight;
+
+	for (int iteration = 0; iteration < iterations; iteration++)
+	{
+		float* terrain = mapData->data();
+		float* water = pipeWater.data();
+		float* fluxL = pipeFluxLeft.data();
+		float* fluxR = pipeFluxRight.data();
+		float* fluxT = pipeFluxTop.data();
+		float* fluxB = pipeFluxBottom.data();
+		float* outflowRatio = pipeOutflowRatio.data();
+
+		// 1. outflow flux: accelerate each pipe by the difference of water surface, then scale so a cell can't lose more water than it has
+		// (rain is added everywhere at once, so it doesn't change the surface differences)
+		ParallelRows(height, threads, [&](int firstRow, int lastRow)
+		{
+			for (int y = firstRow; y < lastRow; y++)
+			{
+				size_t row = (size_t)y * width;
+				size_t rowUp = (size_t)std::max(y - 1, 0) * width;
+				size_t rowDown = (size_t)std::min(y + 1, height - 1) * width;
+				for (int x = 0; x < width; x++)
+				{
+					size_t i = row + x;
+					float surface = terrain[i] + water[i];
+					size_t left = row + std::max(x - 1, 0);
+					size_t right = row + std::min(x + 1, width - 1);
+					float fl = std::max(0.0f, fluxL[i] + fluxFactor * (surface - terrain[left] - water[left]));
+					float fr = std::max(0.0f, fluxR[i] + fluxFactor * (surface - terrain[right] - water[right]));
+					float ft = std::max(0.0f, fluxT[i] + fluxFactor * (surface - terrain[rowUp + x] - water[rowUp + x]));
+					float fb = std::max(0.0f, fluxB[i] + fluxFactor * (surface - terrain[rowDown + x] - water[rowDown + x]));
+					// no flow through the border of the map
+					fl = (x > 0) ? fl : 0.0f;
+					fr = (x < width - 1) ? fr : 0.0f;
+					ft = (y > 0) ? ft : 0.0f;
+					fb = (y < height - 1) ? fb : 0.0f;
+
+					float outflow = (fl + fr + ft + fb) * dt;
+					float volume = (water[i] + rain) * cellArea;
+					float scale = (outflow > volume) ? volume / outflow : 1.0f;
+					fluxL[i] = fl * scale;
+					fluxR[i] = fr * scale;
+					fluxT[i] = ft * scale;
+					fluxB[i] = fb * scale;
+					outflowRatio[i] = (volume > 0.0f) ? dt / volume : 0.0f;
+				}
+			}
+		});
+
+		// 2. water height and velocity field from the net flux of every cell
+		ParallelRows(height, threads, [&](int firstRow, int lastRow)
+		{
+			for (int y = firstRow; y < lastRow; y++)
+			{
+				size_t row = (size_t)y * width;
+				size_t rowUp = (size_t)std::max(y - 1, 0) * width;
+				size_t rowDown = (size_t)std::min(y + 1, height - 1) * width;
+				for (int x = 0; x < width; x++)
+				{
+					size_t i = row + x;
+					size_t left = row + std::max(x - 1, 0);
+					size_t right = row + std::min(x + 1, width - 1);
+					// flux coming from each neighbor (zero on the border, where the neighbor is the cell itself and has no pipe towards it)
+					float fromLeft = (x > 0) ? fluxR[left] : 0.0f;
+					float fromRight = (x < width - 1) ? fluxL[right] : 0.0f;
+					float fromTop = (y > 0) ? fluxB[rowUp + x] : 0.0f;
+					float fromBottom = (y < height - 1) ? fluxT[rowDown + x] : 0.0f;
+
+					float oldWater = water[i] + rain;
+					float newWater = std::max(0.0f, oldWater + dt * (fromLeft + fromRight + fromTop + fromBottom - fluxL[i] - fluxR[i] - fluxT[i] - fluxB[i]) / cellArea);
+					water[i] = newWater;
+
+					float averageWater = (oldWater + newWater) * 0.5f;
+					float flowX = (fromLeft - fluxL[i] + fluxR[i] - fromRight) * 0.5f;
+					float flowY = (fromTop - fluxT[i] + fluxB[i] - fromBottom) * 0.5f;
+					bool wet = averageWater > 0.0001f;
+					pipeVelocityX[i] = wet ? flowX / (job.pipeCellLength * averageWater) : 0.0f;
+					pipeVelocityY[i] = wet ? flowY / (job.pipeCellLength * averageWater) : 0.0f;
+				}
+			}
+		});
+
+		// 3. erosion and deposition: compare the sediment transport capacity of the flow with the suspended sediment
+		float* terrainNext = pipeTerrainNext.data();
+		float* sediment = pipeSediment.data();
+		ParallelRows(height, threads, [&](int firstRow, int lastRow)
+		{
+			for (int y = firstRow; y < lastRow; y++)
+			{
+				size_t row = (size_t)y * width;
+				size_t rowUp = (size_t)std::max(y - 1, 0) * width;
+				size_t rowDown = (size_t)std::min(y + 1, height - 1) * width;
+				for (int x = 0; x < width; x++)
+				{
+					size_t i = row + x;
+					float slopeX = (terrain[row + std::min(x + 1, width - 1)] - terrain[row + std::max(x - 1, 0)]) / (2.0f * job.pipeCellLength);
+					float slopeY = (terrain[rowDown + x] - terrain[rowUp + x]) / (2.0f * job.pipeCellLength);
+					float slope2 = slopeX * slopeX + slopeY * slopeY;
+					float sinTilt = std::max(sqrtf(slope2 / (1.0f + slope2)), job.pipeMinTilt);
+					float speed = sqrtf(pipeVelocityX[i] * pipeVelocityX[i] + pipeVelocityY[i] * pipeVelocityY[i]);
+					float depthFactor = std::min(water[i] / job.pipeErosionDepth, 1.0f); // shallow water (and dry ground) can't carry much
+					float capacity = job.pipeSedimentCapacity * sinTilt * speed * depthFactor;
+
+					float carried = sediment[i];
+					float amount = (capacity > carried) ? job.pipeDissolveSpeed * dt * (capacity - carried) : -job.pipeDepositSpeed * dt * (carried - capacity);
+					amount = std::min(amount, terrain[i]); // don't dig below zero
+					terrainNext[i] = terrain[i] - amount;
+					sediment[i] = carried + amount;
+				}
+			}
+		});
+		mapData->swap(pipeTerrainNext);
+		terrain = mapData->data();
+
+		// 4. sediment transport and evaporation: sediment leaves a cell through the pipes in the same proportion as its water,
+		// so the amount of suspended sediment is conserved (fetching it along the velocity field loses mass where flows converge)
+		float* sedimentNext = pipeSedimentNext.data();
+		ParallelRows(height, threads, [&](int firstRow, int lastRow)
+		{
+			for (int y = firstRow; y < lastRow; y++)
+			{
+				size_t row = (size_t)y * width;
+				size_t rowUp = (size_t)std::max(y - 1, 0) * width;
+				size_t rowDown = (size_t)std::min(y + 1, height - 1) * width;
+				for (int x = 0; x < width; x++)
+				{
+					size_t i = row + x;
+					size_t left = row + std::max(x - 1, 0);
+					size_t right = row + std::min(x + 1, width - 1);
+					float fromLeft = (x > 0) ? sediment[left] * fluxR[left] * outflowRatio[left] : 0.0f;
+					float fromRight = (x < width - 1) ? sediment[right] * fluxL[right] * outflowRatio[right] : 0.0f;
+					float fromTop = (y > 0) ? sediment[rowUp + x] * fluxB[rowUp + x] * outflowRatio[rowUp + x] : 0.0f;
+					float fromBottom = (y < height - 1) ? sediment[rowDown + x] * fluxT[rowDown + x] * outflowRatio[rowDown + x] : 0.0f;
+					float kept = std::max(0.0f, 1.0f - (fluxL[i] + fluxR[i] + fluxT[i] + fluxB[i]) * outflowRatio[i]);
+					sedimentNext[i] = sediment[i] * kept + fromLeft + fromRight + fromTop + fromBottom;
+					water[i] *= evaporation;
+				}
+			}
+		});
+		pipeSediment.swap(pipeSedimentNext);
+	}
+}
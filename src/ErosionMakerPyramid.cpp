@@ -0,0 +1,172 @@
+#include "FloatContract.h"
+#include "ErosionMaker.h"
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "ThreadPool.h"
+
+// multiresolution erosion: the map is halved a few times, the coarsest level is eroded first and every level passes the
+// change it went through (eroded minus original heights) up to the next finer one, which starts from its own heights plus
+// that change and refines it. valleys that take millions of droplets to carve on the full map are carved on small levels,
+// where a droplet covers the same ground in a fraction of the steps and brush points.
+
+static const int PYRAMID_ROWS_PER_TASK = 32; // rows of a level resampled by a single task
+static const int PYRAMID_MIN_SIZE = 32; // coarsest level allowed, in cells along its shorter side
+static const int PYRAMID_MIN_LIFETIME = 8; // steps, shorter droplets barely move sediment
+static const int PYRAMID_BATCH_DROPLETS = 1 << 20; // droplets per Erode call, bounds the spawn arrays of the huge coarse batches
+
+// every coarse cell is the average of the (up to) 2x2 fine cells it covers
+static void DownsampleLevel(const std::vector<float>& fine, int fineWidth, int fineHeight, std::vector<float>* coarse, int coarseWidth, int coarseHeight, int threads)
+{
+	coarse->resize((size_t)coarseWidth * coarseHeight);
+	ThreadPool::GetInstance().ParallelForRows(coarseHeight, PYRAMID_ROWS_PER_TASK, threads, [&](int firstRow, int lastRow)
+	{
+		for (int y = firstRow; y < lastRow; y++)
+		{
+			const float* top = fine.data() + (size_t)(2 * y) * fineWidth;
+			const float* bottom = fine.data() + (size_t)std::min(2 * y + 1, fineHeight - 1) * fineWidth;
+			float* row = coarse->data() + (size_t)y * coarseWidth;
+			for (int x = 0; x < coarseWidth; x++)
+			{
+				int left = 2 * x;
+				int right = std::min(2 * x + 1, fineWidth - 1);
+				row[x] = (top[left] + top[right] + bottom[left] + bottom[right]) * 0.25f;
+			}
+		}
+	});
+}
+
+// position of fine cell on the coarse axis: coarse cell centers sit between the 2 fine cells they average, clamped at the ends
+static void GetUpsampleCoordinate(int fine, int coarseCells, int* first, float* weight)
+{
+	float coarse = std::min(std::max((fine + 0.5f) * 0.5f - 0.5f, 0.0f), (float)(coarseCells - 1));
+	*first = std::min((int)coarse, coarseCells - 2); // levels have at least PYRAMID_MIN_SIZE cells per side
+	*weight = coarse - (float)*first;
+}
+
+// adds coarse to fine with bilinear interpolation
+static void AddUpsampledLevel(const std::vector<float>& coarse, int coarseWidth, int coarseHeight, float* fine, int fineWidth, int fineHeight, int threads)
+{
+	std::vector<int> columns((size_t)fineWidth);
+	std::vector<float> columnWeights((size_t)fineWidth);
+	for (int x = 0; x < fineWidth; x++)
+	{
+		GetUpsampleCoordinate(x, coarseWidth, &columns[x], &columnWeights[x]);
+	}
+	ThreadPool::GetInstance().ParallelForRows(fineHeight, PYRAMID_ROWS_PER_TASK, threads, [&](int firstRow, int lastRow)
+	{
+		for (int y = firstRow; y < lastRow; y++)
+		{
+			int coarseRow;
+			float weightY;
+			GetUpsampleCoordinate(y, coarseHeight, &coarseRow, &weightY);
+			const float* top = coarse.data() + (size_t)coarseRow * coarseWidth;
+			const float* bottom = top + coarseWidth;
+			float* row = fine + (size_t)y * fineWidth;
+			for (int x = 0; x < fineWidth; x++)
+			{
+				int x0 = columns[x];
+				float weightX = columnWeights[x];
+				float upper = top[x0] + (top[x0 + 1] - top[x0]) * weightX;
+				float lower = bottom[x0] + (bottom[x0 + 1] - bottom[x0]) * weightX;
+				row[x] += upper + (lower - upper) * weightY;
+			}
+		}
+	});
+}
+
+ErosionProgress ErosionMaker::ErodeMultiresolution(std::vector<float>* mapData, int mapWidth, int mapHeight, int numIterations, int levels)
+{
+	const ErosionParameters full = parameters;
+	int threads = (full.threadCount <= 0) ? ThreadPool::GetHardwareThreadCount() : full.threadCount;
+
+	// level 0 is the map, every level is half the size of the previous one (rounded up)
+	std::vector<int> widths(1, mapWidth);
+	std::vector<int> heights(1, mapHeight);
+	while ((int)widths.size() <= levels && std::min(widths.back(), heights.back()) >= 2 * PYRAMID_MIN_SIZE)
+	{
+		widths.push_back((widths.back() + 1) / 2);
+		heights.push_back((heights.back() + 1) / 2);
+	}
+	int coarsest = (int)widths.size() - 1;
+
+	ErosionProgress progress = { 0, 0, false, false };
+	std::vector<long long> levelDroplets(widths.size());
+	double droplets = std::max(numIterations, 0);
+	for (int level = 0; level <= coarsest; level++)
+	{
+		levelDroplets[level] = (long long)droplets;
+		progress.requested += levelDroplets[level];
+		droplets *= full.multiresolutionDropletGain;
+	}
+
+	std::vector<std::vector<float>> originals(widths.size()); // heights of every coarse level before erosion, level 0 is the map
+	for (int level = 1; level <= coarsest; level++)
+	{
+		DownsampleLevel(level == 1 ? *mapData : originals[level - 1], widths[level - 1], heights[level - 1], &originals[level], widths[level], heights[level], threads);
+	}
+
+	// droplets keep the size they have on the full map: radius and lifetime shrink with the cells of the level, a step
+	// evaporates the water of the 2^level steps it replaces, and the capacity shrinks as a height moved on a level cell
+	// is moved on the 4^level map cells it covers
+	job = full;
+	job.model = ErosionModel::DROPLETS;
+
+	// the full map is eroded in place: cancelling before it leaves the map untouched, during it keeps the work done.
+	// the coarse levels reuse the dirty mask, the tiles pending on the map are kept aside
+	PrepareDirtyTiles(mapWidth, mapHeight);
+	std::vector<unsigned long long> pendingTiles = dirtyTiles;
+	bool mapChanged = false;
+	std::vector<float> eroded;
+	std::vector<float> change; // eroded minus original heights of the previous (coarser) level
+	for (int level = coarsest; level >= 0 && !progress.cancelled; level--)
+	{
+		int width = widths[level];
+		int height = heights[level];
+		if (level > 0)
+			eroded = originals[level];
+		std::vector<float>* levelMap = (level == 0) ? mapData : &eroded;
+		if (level < coarsest)
+		{
+			AddUpsampledLevel(change, widths[level + 1], heights[level + 1], levelMap->data(), width, height, threads);
+			mapChanged = level == 0;
+		}
+
+		float scale = (float)(1 << level);
+		job.erosionRadius = std::max(2, (int)(full.erosionRadius / scale + 0.5f));
+		job.maxDropletLifetime = std::max(PYRAMID_MIN_LIFETIME, (int)(full.maxDropletLifetime / scale + 0.5f));
+		job.sedimentCapacityFactor = full.sedimentCapacityFactor / (scale * scale);
+		job.minSedimentCapacity = full.minSedimentCapacity / (scale * scale);
+		job.evaporateSpeed = 1.0f - powf(1.0f - full.evaporateSpeed, scale);
+		for (long long done = 0; done < levelDroplets[level]; done += PYRAMID_BATCH_DROPLETS)
+		{
+			if (cancelRequested)
+			{
+				progress.cancelled = true;
+				break;
+			}
+			int batch = (int)std::min((long long)PYRAMID_BATCH_DROPLETS, levelDroplets[level] - done);
+			ErodeJob(levelMap, width, height, batch, false);
+			progress.done += batch;
+			mapChanged = mapChanged || level == 0;
+		}
+
+		if (level > 0)
+		{
+			const std::vector<float>& original = originals[level];
+			change.resize(eroded.size());
+			for (size_t i = 0; i < eroded.size(); i++)
+			{
+				change[i] = eroded[i] - original[i];
+			}
+		}
+	}
+
+	progress.finished = !progress.cancelled;
+	PrepareDirtyTiles(mapWidth, mapHeight);
+	if (!mapChanged)
+		dirtyTiles = pendingTiles; // cancelled before the full map
+	else if (coarsest > 0)
+		MarkAllDirty(mapWidth, mapHeight); // the whole map moved with the change of the coarse levels
+	return progress;
+}
@@ -0,0 +1,223 @@
+#include "FloatContract.h"
+#include "ErosionMaker.h"
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "ThreadPool.h"
+
+// thermal (talus) erosion: material crumbles from a cell towards every neighbor that lies lower than the talus angle allows.
+// an iteration is two gather-only passes (a cell only writes itself), reading the current map and writing a second buffer
+// that is swapped with the map at the end, so rows can be split among threads without races and the result doesn't depend on them.
+
+static const int THERMAL_ROWS_PER_TASK = 16; // rows of the map processed by a single task
+static const int THERMAL_NEIGHBORS = 8;
+static const int thermalNeighborX[THERMAL_NEIGHBORS] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+static const int thermalNeighborY[THERMAL_NEIGHBORS] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+
+// height above the talus limit by which "from" exceeds "to", 0 if the slope between them is stable
+static inline float TalusExcess(float from, float to, float limit)
+{
+	return std::max(0.0f, from - to - limit);
+}
+
+// max height difference allowed towards every neighbor, diagonals are further away
+static void GetTalusLimits(float talusHeight, float* limits)
+{
+	for (int k = 0; k < THERMAL_NEIGHBORS; k++)
+	{
+		bool diagonal = thermalNeighborX[k] != 0 && thermalNeighborY[k] != 0;
+		limits[k] = diagonal ? talusHeight * 1.41421356f : talusHeight;
+	}
+}
+
+// pass 1 for a cell near the border: how much of its excess the cell gives to each lower neighbor.
+// a cell moves rate * (largest excess) in total, split among its neighbors proportionally to their excess
+static float ThermalOutflowScaleChecked(const float* terrain, int mapWidth, int mapHeight, int x, int y, const float* limits, float rate)
+{
+	float height = terrain[(size_t)y * mapWidth + x];
+	float total = 0.0f;
+	float largest = 0.0f;
+	for (int k = 0; k < THERMAL_NEIGHBORS; k++)
+	{
+		int neighborX = x + thermalNeighborX[k];
+		int neighborY = y + thermalNeighborY[k];
+		if (neighborX < 0 || neighborX >= mapWidth || neighborY < 0 || neighborY >= mapHeight)
+			continue; // nothing falls off the map
+		float excess = TalusExcess(height, terrain[(size_t)neighborY * mapWidth + neighborX], limits[k]);
+		total += excess;
+		largest = std::max(largest, excess);
+	}
+	return rate * largest / std::max(total, 1e-20f); // 0 when the cell is stable
+}
+
+// pass 2 for a cell near the border: new height = height - what the cell gives + what its higher neighbors give to it
+static float ThermalGatherChecked(const float* terrain, const float* outflowScale, int mapWidth, int mapHeight, int x, int y, const float* limits)
+{
+	size_t i = (size_t)y * mapWidth + x;
+	float height = terrain[i];
+	float given = 0.0f;
+	float received = 0.0f;
+	for (int k = 0; k < THERMAL_NEIGHBORS; k++)
+	{
+		int neighborX = x + thermalNeighborX[k];
+		int neighborY = y + thermalNeighborY[k];
+		if (neighborX < 0 || neighborX >= mapWidth || neighborY < 0 || neighborY >= mapHeight)
+			continue;
+		size_t neighbor = (size_t)neighborY * mapWidth + neighborX;
+		given += TalusExcess(height, terrain[neighbor], limits[k]);
+		received += outflowScale[neighbor] * TalusExcess(terrain[neighbor], height, limits[k]); // talus limit is symmetric, so this is what the neighbor computed in pass 1
+	}
+	return height - outflowScale[i] * given + received;
+}
+
+// pass 1 for the interior of a row, same as ThermalOutflowScaleChecked with the neighbors unrolled so the loop vectorizes
+static void ThermalOutflowRow(const float* terrain, float* outflowScale, int mapWidth, int y, const float* limits, float rate)
+{
+	size_t row = (size_t)y * mapWidth;
+	const float* up = terrain + row - mapWidth;
+	const float* center = terrain + row;
+	const float* down = terrain + row + mapWidth;
+	float* scale = outflowScale + row;
+	const float straight = limits[1];
+	const float diagonal = limits[0];
+	for (int x = 1; x < mapWidth - 1; x++)
+	{
+		float height = center[x];
+		float e0 = TalusExcess(height, up[x - 1], diagonal);
+		float e1 = TalusExcess(height, up[x], straight);
+		float e2 = TalusExcess(height, up[x + 1], diagonal);
+		float e3 = TalusExcess(height, center[x - 1], straight);
+		float e4 = TalusExcess(height, center[x + 1], straight);
+		float e5 = TalusExcess(height, down[x - 1], diagonal);
+		float e6 = TalusExcess(height, down[x], straight);
+		float e7 = TalusExcess(height, down[x + 1], diagonal);
+		float total = ((e0 + e1) + (e2 + e3)) + ((e4 + e5) + (e6 + e7));
+		float largest = std::max(std::max(std::max(e0, e1), std::max(e2, e3)), std::max(std::max(e4, e5), std::max(e6, e7)));
+		scale[x] = rate * largest / std::max(total, 1e-20f);
+	}
+}
+
+// pass 2 for the interior of a row, same as ThermalGatherChecked unrolled
+static void ThermalGatherRow(const float* terrain, const float* outflowScale, float* terrainNext, int mapWidth, int y, const float* limits)
+{
+	size_t row = (size_t)y * mapWidth;
+	const float* up = terrain + row - mapWidth;
+	const float* center = terrain + row;
+	const float* down = terrain + row + mapWidth;
+	const float* scaleUp = outflowScale + row - mapWidth;
+	const float* scale = outflowScale + row;
+	const float* scaleDown = outflowScale + row + mapWidth;
+	float* next = terrainNext + row;
+	const float straight = limits[1];
+	const float diagonal = limits[0];
+	for (int x = 1; x < mapWidth - 1; x++)
+	{
+		float height = center[x];
+		float given = ((TalusExcess(height, up[x - 1], diagonal) + TalusExcess(height, up[x], straight))
+			+ (TalusExcess(height, up[x + 1], diagonal) + TalusExcess(height, center[x - 1], straight)))
+			+ ((TalusExcess(height, center[x + 1], straight) + TalusExcess(height, down[x - 1], diagonal))
+			+ (TalusExcess(height, down[x], straight) + TalusExcess(height, down[x + 1], diagonal)));
+		float received = ((scaleUp[x - 1] * TalusExcess(up[x - 1], height, diagonal) + scaleUp[x] * TalusExcess(up[x], height, straight))
+			+ (scaleUp[x + 1] * TalusExcess(up[x + 1], height, diagonal) + scale[x - 1] * TalusExcess(center[x - 1], height, straight)))
+			+ ((scale[x + 1] * TalusExcess(center[x + 1], height, straight) + scaleDown[x - 1] * TalusExcess(down[x - 1], height, diagonal))
+			+ (scaleDown[x] * TalusExcess(down[x], height, straight) + scaleDown[x + 1] * TalusExcess(down[x + 1], height, diagonal)));
+		next[x] = height - scale[x] * given + received;
+	}
+}
+
+// a cell changes when it or one of its neighbors sheds material: marks the runs of the row that shed, with a 1 cell margin
+void ErosionMaker::MarkThermalRow(const float* outflowScale, int mapWidth, int mapHeight, int y, unsigned long long* dirty)
+{
+	const float* scaleRow = outflowScale + (size_t)y * mapWidth;
+	for (int x0 = 0; x0 < mapWidth; x0 += DIRTY_TILE_SIZE)
+	{
+		int x1 = std::min(x0 + DIRTY_TILE_SIZE, mapWidth);
+		bool moved = false;
+		for (int x = x0; x < x1; x++)
+			moved |= scaleRow[x] > 0.0f;
+		if (moved)
+			MarkDirtyRect(dirty, mapWidth, mapHeight, x0 - 1, y - 1, x1, y + 1);
+	}
+}
+
+void ErosionMaker::ErodeThermal(std::vector<float>* mapData, int mapWidth, int mapHeight, int iterations)
+{
+	job = parameters;
+	size_t cells = (size_t)mapWidth * mapHeight;
+	if (mapWidth < 3 || mapHeight < 3 || iterations <= 0)
+		return;
+	thermalTerrainNext.resize(cells);
+	thermalOutflowScale.resize(cells);
+	// pass 1 marks the rows of a task in the dirty mask of the pool thread running it, merged after the iterations
+	PrepareDirtyTiles(mapWidth, mapHeight);
+	workerDirtyTiles.resize((size_t)ThreadPool::GetInstance().GetThreadCount());
+	for (size_t worker = 0; worker < workerDirtyTiles.size(); worker++)
+	{
+		workerDirtyTiles[worker].assign(dirtyTiles.size(), 0);
+	}
+
+	int threads = (job.threadCount <= 0) ? ThreadPool::GetHardwareThreadCount() : job.threadCount;
+	ThreadPool& pool = ThreadPool::GetInstance();
+	float limits[THERMAL_NEIGHBORS];
+	GetTalusLimits(tanf(job.thermalTalusAngle * 3.14159265f / 180.0f) * job.thermalCellLength, limits);
+	const float rate = std::min(std::max(job.thermalRate, 0.0f), 0.5f); // more than half the excess would overshoot and oscillate
+	const int width = mapWidth;
+	const int height = mapHeight;
+
+	for (int iteration = 0; iteration < iterations; iteration++)
+	{
+		const float* terrain = mapData->data();
+		float* outflowScale = thermalOutflowScale.data();
+		float* terrainNext = thermalTerrainNext.data();
+
+		// ParallelFor rather than ParallelForRows: the task needs its worker for the dirty mask
+		int rowTasks = (height + THERMAL_ROWS_PER_TASK - 1) / THERMAL_ROWS_PER_TASK;
+		pool.ParallelFor(rowTasks, threads, [&](int task, int worker)
+		{
+			int firstRow = task * THERMAL_ROWS_PER_TASK;
+			int lastRow = std::min(firstRow + THERMAL_ROWS_PER_TASK, height);
+			for (int y = firstRow; y < lastRow; y++)
+			{
+				if (y == 0 || y == height - 1)
+				{
+					for (int x = 0; x < width; x++)
+						outflowScale[(size_t)y * width + x] = ThermalOutflowScaleChecked(terrain, width, height, x, y, limits, rate);
+				}
+				else
+				{
+					// border cells are checked, the interior runs the branch-free loop
+					outflowScale[(size_t)y * width] = ThermalOutflowScaleChecked(terrain, width, height, 0, y, limits, rate);
+					ThermalOutflowRow(terrain, outflowScale, width, y, limits, rate);
+					outflowScale[(size_t)y * width + width - 1] = ThermalOutflowScaleChecked(terrain, width, height, width - 1, y, limits, rate);
+				}
+				MarkThermalRow(outflowScale, width, height, y, workerDirtyTiles[worker].data());
+			}
+		});
+
+		pool.ParallelForRows(height, THERMAL_ROWS_PER_TASK, threads, [&](int firstRow, int lastRow)
+		{
+			for (int y = firstRow; y < lastRow; y++)
+			{
+				if (y == 0 || y == height - 1)
+				{
+					for (int x = 0; x < width; x++)
+						terrainNext[(size_t)y * width + x] = ThermalGatherChecked(terrain, outflowScale, width, height, x, y, limits);
+					continue;
+				}
+				terrainNext[(size_t)y * width] = ThermalGatherChecked(terrain, outflowScale, width, height, 0, y, limits);
+				ThermalGatherRow(terrain, outflowScale, terrainNext, width, y, limits);
+				terrainNext[(size_t)y * width + width - 1] = ThermalGatherChecked(terrain, outflowScale, width, height, width - 1, y, limits);
+			}
+		});
+
+		mapData->swap(thermalTerrainNext); // ping-pong: the old map becomes the next target
+	}
+
+	for (const std::vector<unsigned long long>& workerDirty : workerDirtyTiles)
+	{
+		for (size_t word = 0; word < dirtyTiles.size(); word++)
+		{
+			dirtyTiles[word] |= workerDirty[word];
+		}
+	}
+}
@@ -0,0 +1,440 @@
+#include "FloatContract.h"
+#include "ErosionVerification.h"
+#include "ChunkStreamer.h"
+#include "NormalMap.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+// sizes cover square, rectangular and odd maps (partial dirty tiles, partial tiled blocks), radii the clipped brush
+// near the borders and the full one, droplet counts a light and a well worn map
+static const VerificationCase verificationCases[] =
+{
+	{ 64, 64, 2, 500, 0x8afba506ee3ba352ull },
+	{ 64, 64, 3, 5000, 0xd9c5ff8302f038caull },
+	{ 64, 64, 6, 5000, 0xa2b20146fd24ba84ull },
+	{ 96, 80, 2, 5000, 0x02f747527444bf49ull },
+	{ 96, 80, 3, 500, 0x1917aeba053b1f48ull },
+	{ 96, 80, 6, 5000, 0xac1779beacfca61cull },
+	{ 257, 129, 2, 5000, 0x1a41ebd428f11b16ull },
+	{ 257, 129, 3, 20000, 0x42d5da2e70444ef4ull },
+	{ 257, 129, 6, 20000, 0x1cde49bc87b5b88bull },
+	{ 256, 256, 4, 50000, 0xa1f66459fa8c4b08ull },
+};
+
+static const ErosionVariant erosionVariants[] =
+{
+	{ "threads", ErosionKernel::SCALAR, HeightmapLayout::ROW_MAJOR, 0, false, true },
+	{ "tiled", ErosionKernel::SCALAR, HeightmapLayout::TILED, 1, false, true },
+	{ "tiled threads", ErosionKernel::SCALAR, HeightmapLayout::TILED, 0, false, true },
+	{ "packet", ErosionKernel::PACKET, HeightmapLayout::ROW_MAJOR, 1, false, false },
+	{ "incremental", ErosionKernel::SCALAR, HeightmapLayout::ROW_MAJOR, 1, true, false },
+};
+
+static const ErosionVariant referenceVariant = { "reference", ErosionKernel::SCALAR, HeightmapLayout::ROW_MAJOR, 1, false, true };
+
+// two instances of their own eroding the case at the same time, on the pool, each must give the reference
+static const ErosionVariant concurrentVariant = { "instances", ErosionKernel::SCALAR, HeightmapLayout::ROW_MAJOR, 0, false, true };
+
+// maps of the island shaping checks, odd widths leave a tail narrower than the SIMD lanes
+static const int islandSizes[][2] = { { 64, 64 }, { 257, 129 } };
+static const GradientType islandGradients[] = { GradientType::SQUARE, GradientType::CIRCLE, GradientType::DIAMOND, GradientType::STAR };
+static const char* islandGradientNames[] = { "square", "circle", "diamond", "star" }; // in islandGradients order
+
+// remap curves checked against their exact curve: kinks (the worst case of the table), smooth terraces, a dip, and a
+// plateau ending below 1 so a height on the last point shows whether it's remapped
+typedef struct
+{
+	const char* name;
+	RemapInterpolation interpolation;
+	std::vector<Vector2> points; // empty = the beach curve
+} RemapCheck;
+
+static const RemapCheck remapChecks[] =
+{
+	{ "beach", RemapInterpolation::PIECEWISE_LINEAR, {} },
+	{ "beach cubic", RemapInterpolation::MONOTONE_CUBIC, {} },
+	{ "terraces cubic", RemapInterpolation::MONOTONE_CUBIC, { { 0.0f, 0.0f }, { 0.1f, 0.05f }, { 0.2f, 0.2f }, { 0.3f, 0.22f }, { 0.45f, 0.4f }, { 0.55f, 0.42f }, { 0.7f, 0.6f }, { 0.8f, 0.62f }, { 1.0f, 1.0f } } },
+	{ "craters", RemapInterpolation::PIECEWISE_LINEAR, { { 0.0f, 0.0f }, { 0.3f, 0.4f }, { 0.4f, 0.3f }, { 1.0f, 1.0f } } },
+	{ "plateau", RemapInterpolation::PIECEWISE_LINEAR, { { 0.0f, 0.0f }, { 0.6f, 0.65f }, { 1.0f, 0.7f } } },
+};
+
+// integer hash of a lattice point, in range [0, 1) with 24 bits so the conversion is exact
+static float LatticeValue(unsigned int x, unsigned int y, unsigned int octave)
+{
+	unsigned int hash = x * 0x8DA6B343u ^ y * 0xD8163841u ^ octave * 0xCB1AB31Fu;
+	hash ^= hash >> 15;
+	hash *= 0x2C1B3C6Du;
+	hash ^= hash >> 12;
+	return (hash & 0xFFFFFF) / 16777216.0f;
+}
+
+// smoothly interpolated lattice values, period cells apart
+static float ValueNoise(int x, int y, int period, unsigned int octave)
+{
+	unsigned int cellX = (unsigned int)(x / period);
+	unsigned int cellY = (unsigned int)(y / period);
+	float fx = (float)(x % period) / (float)period;
+	float fy = (float)(y % period) / (float)period;
+	fx = fx * fx * (3.0f - 2.0f * fx);
+	fy = fy * fy * (3.0f - 2.0f * fy);
+	float top = LatticeValue(cellX, cellY, octave) + (LatticeValue(cellX + 1, cellY, octave) - LatticeValue(cellX, cellY, octave)) * fx;
+	float bottom = LatticeValue(cellX, cellY + 1, octave) + (LatticeValue(cellX + 1, cellY + 1, octave) - LatticeValue(cellX, cellY + 1, octave)) * fx;
+	return top + (bottom - top) * fy;
+}
+
+void ErosionVerification::GenerateMap(std::vector<float>* map, int mapWidth, int mapHeight)
+{
+	map->resize((size_t)mapWidth * mapHeight);
+	for (int y = 0; y < mapHeight; y++)
+	{
+		for (int x = 0; x < mapWidth; x++)
+		{
+			float noise = ValueNoise(x, y, 24, 0) * 0.6f + ValueNoise(x, y, 7, 1) * 0.3f + ValueNoise(x, y, 3, 2) * 0.1f;
+			// island: heights fade out towards the borders (squared distances, no square root)
+			float dx = (2.0f * x - (mapWidth - 1)) / (float)mapWidth;
+			float dy = (2.0f * y - (mapHeight - 1)) / (float)mapHeight;
+			float falloff = std::max(0.0f, 1.0f - (dx * dx + dy * dy));
+			(*map)[(size_t)y * mapWidth + x] = noise * falloff;
+		}
+	}
+}
+
+unsigned long long ErosionVerification::HashMap(const std::vector<float>& map)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	for (float height : map)
+	{
+		unsigned int bits;
+		memcpy(&bits, &height, sizeof(bits));
+		hash = (hash ^ bits) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static double SumHeights(const std::vector<float>& map)
+{
+	double sum = 0.0;
+	for (float height : map)
+		sum += height;
+	return sum;
+}
+
+static double RmsDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		double difference = (double)a[i] - b[i];
+		sum += difference * difference;
+	}
+	return sqrt(sum / a.size());
+}
+
+static double MaxDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+	double largest = 0.0;
+	for (size_t i = 0; i < a.size(); i++)
+		largest = std::max(largest, fabs((double)a[i] - b[i]));
+	return largest;
+}
+
+void ErosionVerification::Erode(ErosionMaker* maker, std::vector<float>* map, const VerificationCase& verificationCase, const ErosionVariant& variant)
+{
+	GenerateMap(map, verificationCase.mapWidth, verificationCase.mapHeight);
+	maker->parameters.model = ErosionModel::DROPLETS;
+	maker->parameters.erosionRadius = verificationCase.radius;
+	maker->parameters.kernel = variant.kernel;
+	maker->parameters.layout = variant.layout;
+	maker->parameters.threadCount = variant.threads;
+	maker->SetSeed(SEED);
+	if (!variant.incremental)
+	{
+		maker->Erode(map, verificationCase.mapWidth, verificationCase.mapHeight, verificationCase.droplets, false);
+		return;
+	}
+	maker->StartErode(verificationCase.droplets);
+	while (!maker->ContinueErode(map, verificationCase.mapWidth, verificationCase.mapHeight, 0.001f).finished)
+	{
+	}
+}
+
+bool ErosionVerification::Run(FILE* report)
+{
+	// the checks change the parameters, they are given back at the end
+	ErosionParameters parameters = erosionMaker->parameters;
+
+	int failures = 0;
+	int checks = 0;
+	int skipped = 0; // checks that would test nothing on this build or CPU
+	std::vector<float> original, reference, eroded;
+	for (const VerificationCase& verificationCase : verificationCases)
+	{
+		char caseName[64];
+		snprintf(caseName, sizeof(caseName), "%dx%d r%d %d droplets", verificationCase.mapWidth, verificationCase.mapHeight, verificationCase.radius, verificationCase.droplets);
+		GenerateMap(&original, verificationCase.mapWidth, verificationCase.mapHeight);
+		double originalMass = SumHeights(original);
+		double massTolerance = originalMass * MASS_TOLERANCE;
+
+		// golden output
+		Erode(erosionMaker, &reference, verificationCase, referenceVariant);
+		unsigned long long hash = HashMap(reference);
+		double referenceMass = SumHeights(reference);
+		double erosionRms = RmsDifference(reference, original);
+		bool golden = verificationCase.goldenHash == 0 || hash == verificationCase.goldenHash;
+		bool massKept = referenceMass <= originalMass + massTolerance;
+		fprintf(report, "%-4s %-28s %-14s hash %016llx%s, mass %+.6f%%\n", (golden && massKept) ? "ok" : "FAIL", caseName, "reference", hash,
+			verificationCase.goldenHash == 0 ? " (no golden hash)" : (golden ? "" : " differs from the golden hash"), (referenceMass / originalMass - 1.0) * 100.0);
+		failures += (golden && massKept) ? 0 : 1;
+		checks++;
+
+		for (const ErosionVariant& variant : erosionVariants)
+		{
+			if (variant.kernel == ErosionKernel::PACKET && !ErosionMaker::HasPacketKernel())
+			{
+				// the packet kernel would run the scalar one, the comparison would pass without testing anything
+				fprintf(report, "%-4s %-28s %-14s no SIMD packet kernel on this build and CPU\n", "skip", caseName, variant.name);
+				skipped++;
+				continue;
+			}
+			Erode(erosionMaker, &eroded, verificationCase, variant);
+			double mass = SumHeights(eroded);
+			massKept = mass <= originalMass + massTolerance;
+			bool passed;
+			if (variant.exact)
+			{
+				passed = eroded == reference;
+				fprintf(report, "%-4s %-28s %-14s %s, mass %+.6f%%\n", (passed && massKept) ? "ok" : "FAIL", caseName, variant.name,
+					passed ? "identical" : "DIFFERS from the reference", (mass / originalMass - 1.0) * 100.0);
+			}
+			else
+			{
+				// another droplet order wears other valleys, the difference must stay well below the erosion itself
+				double rms = RmsDifference(eroded, reference);
+				double rmsRatio = (erosionRms > 0.0) ? rms / erosionRms : 0.0;
+				// and about as much material must be carried away
+				double removedRatio = (originalMass > referenceMass) ? (originalMass - mass) / (originalMass - referenceMass) : 1.0;
+				passed = rmsRatio <= MAX_RMS_RATIO && fabs(removedRatio - 1.0) <= MAX_REMOVED_DIFFERENCE;
+				fprintf(report, "%-4s %-28s %-14s max %.6f, rms %.6f (%.2f of the erosion), mass %+.6f%% (%.3f of the reference loss)\n", (passed && massKept) ? "ok" : "FAIL", caseName, variant.name,
+					MaxDifference(eroded, reference), rms, rmsRatio, (mass / originalMass - 1.0) * 100.0, removedRatio);
+			}
+			failures += (passed && massKept) ? 0 : 1;
+			checks++;
+		}
+
+		// instances share the pool and the brush cache, neither may disturb the other
+		ErosionMaker first(erosionMaker->parameters);
+		ErosionMaker second(erosionMaker->parameters);
+		std::vector<float> secondMap;
+		std::thread secondThread([&]() { Erode(&second, &secondMap, verificationCase, concurrentVariant); });
+		Erode(&first, &eroded, verificationCase, concurrentVariant);
+		secondThread.join();
+		bool passed = eroded == reference && secondMap == reference;
+		fprintf(report, "%-4s %-28s %-14s %s\n", passed ? "ok" : "FAIL", caseName, concurrentVariant.name, passed ? "identical" : "DIFFERS from the reference");
+		failures += passed ? 0 : 1;
+		checks++;
+	}
+	// the fused island shaping must give the heights of the passes it replaces, and their upload encoding
+	std::vector<float> noise, shaped;
+	std::vector<unsigned short> values, expectedValues;
+	for (const int* size : islandSizes)
+	{
+		int mapWidth = size[0];
+		int mapHeight = size[1];
+		char caseName[64];
+		snprintf(caseName, sizeof(caseName), "%dx%d island", mapWidth, mapHeight);
+		GenerateMap(&noise, mapWidth, mapHeight);
+		for (size_t type = 0; type < sizeof(islandGradients) / sizeof(islandGradients[0]); type++)
+		{
+			reference = noise;
+			erosionMaker->Gradient(&reference, mapWidth, mapHeight, 0.5f, islandGradients[type]);
+			erosionMaker->Remap(&reference, mapWidth, mapHeight);
+			expectedValues.resize(reference.size());
+			ErosionMaker::EncodeHeights(reference.data(), expectedValues.data(), (int)reference.size());
+			shaped.resize(noise.size());
+			values.resize(noise.size());
+			erosionMaker->ShapeIsland(noise.data(), shaped.data(), values.data(), mapWidth, mapHeight, islandGradients[type]);
+			bool passed = shaped == reference && values == expectedValues;
+			fprintf(report, "%-4s %-28s %-14s %s\n", passed ? "ok" : "FAIL", caseName, islandGradientNames[type], passed ? "identical to Gradient and Remap" : "DIFFERS from Gradient and Remap");
+			failures += passed ? 0 : 1;
+			checks++;
+		}
+	}
+
+	// normal maps: the texels hold the normals of GetNormal, and recomputing rects of a changed map (at any column, so the
+	// SIMD lanes start anywhere) gives the texels of a whole new pass
+	for (const int* size : islandSizes)
+	{
+		int mapWidth = size[0];
+		int mapHeight = size[1];
+		char caseName[64];
+		snprintf(caseName, sizeof(caseName), "%dx%d normals", mapWidth, mapHeight);
+		GenerateMap(&reference, mapWidth, mapHeight);
+		NormalMap normals(mapWidth, mapHeight);
+		normals.Calculate(reference);
+		float maxError = 0.0f;
+		for (int y = 0; y < mapHeight; y++)
+		{
+			for (int x = 0; x < mapWidth; x++)
+			{
+				Vector3 expected = erosionMaker->GetNormal(&reference, mapWidth, mapHeight, x, y);
+				Vector3 decoded = normals.GetNormal(x, y);
+				maxError = std::max(maxError, std::max(fabsf(decoded.x - expected.x), std::max(fabsf(decoded.y - expected.y), fabsf(decoded.z - expected.z))));
+			}
+		}
+		std::vector<NormalRect> rects = { { 0, 0, 7, 5 }, { 3, mapHeight / 2, mapWidth - 3, 9 }, { mapWidth - 6, mapHeight - 4, 6, 4 } };
+		for (const NormalRect& rect : rects)
+		{
+			for (int y = rect.y + 1; y < rect.y + rect.height - 1; y++)
+			{
+				for (int x = rect.x + 1; x < rect.x + rect.width - 1; x++)
+					reference[(size_t)y * mapWidth + x] += 0.01f * ((x + y) % 3); // the cells of a rect change the normals of its border
+			}
+		}
+		normals.Calculate(reference, rects);
+		NormalMap recomputed(mapWidth, mapHeight);
+		recomputed.Calculate(reference);
+		bool identical = memcmp(normals.GetTexels(), recomputed.GetTexels(), (size_t)mapWidth * mapHeight * NormalMap::TEXEL_BYTES) == 0;
+		bool passed = identical && maxError <= NORMAL_TOLERANCE;
+		fprintf(report, "%-4s %-28s %-14s max error %.4f, rects %s\n", passed ? "ok" : "FAIL", caseName, "NormalMap", maxError, identical ? "identical" : "DIFFER from a whole pass");
+		failures += passed ? 0 : 1;
+		checks++;
+	}
+
+	// remap curves: the SIMD lookup gives the scalar one bit for bit, the table stays close to the curve, and monotone
+	// points give a monotone curve
+	GenerateMap(&noise, islandSizes[1][0], islandSizes[1][1]);
+	const float specialHeights[] = { -0.5f, 0.0f, 0.99999994f, 1.0f, 1.5f, NAN };
+	noise.insert(noise.end(), specialHeights, specialHeights + sizeof(specialHeights) / sizeof(specialHeights[0]));
+	for (const RemapCheck& check : remapChecks)
+	{
+		RemapCurve curve;
+		if (!check.points.empty())
+			curve.SetPoints(check.points, check.interpolation);
+		else
+			curve.SetPoints(RemapCurve::GetDefaultPoints(), check.interpolation);
+		shaped = noise;
+		curve.Apply(shaped.data(), (int)shaped.size());
+		bool identical = true;
+		for (size_t i = 0; i < noise.size(); i++)
+		{
+			float expected = curve.Evaluate(noise[i]);
+			identical = identical && memcmp(&expected, &shaped[i], sizeof(float)) == 0; // NaN compares too
+		}
+		bool monotonePoints = true;
+		const std::vector<Vector2>& points = curve.GetPoints();
+		for (size_t i = 1; i < points.size(); i++)
+			monotonePoints = monotonePoints && points[i].y >= points[i - 1].y;
+		bool monotone = true;
+		for (int step = 1; step < 4 * RemapCurve::TABLE_CELLS && monotonePoints; step++)
+			monotone = monotone && curve.Evaluate(step / (4.0f * RemapCurve::TABLE_CELLS)) >= curve.Evaluate((step - 1) / (4.0f * RemapCurve::TABLE_CELLS));
+		// a height right on the last point takes its remapped height, in the SIMD lanes too
+		const Vector2& last = points.back();
+		float ends[4] = { last.x, last.x, last.x, last.x };
+		curve.Apply(ends, 4);
+		bool endpoint = fabsf(curve.EvaluateExact(last.x) - last.y) <= REMAP_TABLE_TOLERANCE && fabsf(ends[0] - last.y) <= REMAP_TABLE_TOLERANCE;
+		float error = curve.GetMaxTableError();
+		bool passed = identical && monotone && endpoint && error <= REMAP_TABLE_TOLERANCE;
+		fprintf(report, "%-4s %-28s %-14s %s, max error %.7f%s%s\n", passed ? "ok" : "FAIL", "remap curve", check.name,
+			identical ? "SIMD identical" : "SIMD DIFFERS", error, monotone ? "" : ", NOT MONOTONE", endpoint ? "" : ", LAST POINT NOT REMAPPED");
+		failures += passed ? 0 : 1;
+		checks++;
+	}
+
+	// noise: the SIMD rows give the scalar cells bit for bit on any thread count (the width leaves a scalar tail), the
+	// heights stay in (0, 1) and aren't flat
+	const char* noiseNames[] = { "fbm", "ridged", "domain warped" }; // in NoiseType order
+	const int noiseWidth = 257, noiseHeight = 129;
+	for (int type = 0; type < 3; type++)
+	{
+		NoiseParameters noise;
+		noise.type = (NoiseType)type;
+		noise.seed = SEED;
+		std::vector<float> serial((size_t)noiseWidth * noiseHeight);
+		std::vector<float> threaded(serial.size());
+		erosionMaker->parameters.threadCount = 1;
+		erosionMaker->GenerateNoise(serial.data(), noiseWidth, noiseHeight, noise);
+		erosionMaker->parameters.threadCount = 0;
+		erosionMaker->GenerateNoise(threaded.data(), noiseWidth, noiseHeight, noise);
+		bool identical = serial == threaded;
+		float low = 1.0f, high = 0.0f;
+		for (int y = 0; y < noiseHeight; y++)
+		{
+			for (int x = 0; x < noiseWidth; x++)
+			{
+				float expected = ErosionMaker::SampleNoise(x, y, noiseWidth, noiseHeight, noise);
+				float height = serial[(size_t)y * noiseWidth + x];
+				identical = identical && memcmp(&expected, &height, sizeof(float)) == 0;
+				low = std::min(low, height);
+				high = std::max(high, height);
+			}
+		}
+		bool passed = identical && low >= 0.0f && high <= 1.0f && high - low >= MIN_NOISE_RANGE;
+		fprintf(report, "%-4s %-28s %-14s %s, heights %.4f to %.4f\n", passed ? "ok" : "FAIL", "noise", noiseNames[type],
+			identical ? "SIMD identical" : "SIMD DIFFERS", low, high);
+		failures += passed ? 0 : 1;
+		checks++;
+	}
+
+	// streamed terrain chunks: neighbors share their edge heights and normals bit for bit (negative coordinates too), and a
+	// chunk comes out the same on any thread count
+	{
+		ChunkSettings settings;
+		settings.chunkCells = 32;
+		settings.haloCells = 8;
+		settings.seamCells = 4;
+		settings.droplets = 2000;
+		settings.seed = SEED;
+		ErosionMaker chunkMaker(settings.erosion);
+		chunkMaker.parameters.threadCount = 1;
+		const ChunkCoord coords[] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+		TerrainChunk chunks[4];
+		for (int i = 0; i < 4; i++)
+			ChunkStreamer::GenerateChunk(&chunkMaker, settings, coords[i], &chunks[i]);
+		TerrainChunk threaded;
+		chunkMaker.parameters.threadCount = 0;
+		ChunkStreamer::GenerateChunk(&chunkMaker, settings, coords[0], &threaded);
+		bool deterministic = threaded.heights == chunks[0].heights && threaded.normals == chunks[0].normals;
+		// the last column of the left chunk against the first of the right one, the last row of the top chunk against the first of the bottom one
+		const int edges[][3] = { { 0, 1, 1 }, { 3, 0, 1 }, { 0, 2, 0 } }; // first chunk, second chunk, along x
+		int side = settings.chunkCells + 1;
+		int mismatches = 0;
+		for (const int* edge : edges)
+		{
+			for (int i = 0; i < side; i++)
+			{
+				size_t first = edge[2] ? (size_t)i * side + side - 1 : (size_t)(side - 1) * side + i;
+				size_t second = edge[2] ? (size_t)i * side : (size_t)i;
+				bool same = chunks[edge[0]].heights[first] == chunks[edge[1]].heights[second] &&
+					memcmp(&chunks[edge[0]].normals[first * NormalMap::TEXEL_BYTES], &chunks[edge[1]].normals[second * NormalMap::TEXEL_BYTES], NormalMap::TEXEL_BYTES) == 0;
+				mismatches += same ? 0 : 1;
+			}
+		}
+		bool varied = chunks[0].maxHeight > chunks[0].minHeight;
+		bool passed = deterministic && mismatches == 0 && varied;
+		fprintf(report, "%-4s %-28s %-14s %i edge cells differ, threads %s\n", passed ? "ok" : "FAIL", "chunk seams", "streamer",
+			mismatches, deterministic ? "identical" : "DIFFER");
+		failures += passed ? 0 : 1;
+		checks++;
+	}
+
+	fprintf(report, "%d of %d checks passed, %d skipped (packet kernel: %s)\n", checks - failures, checks, skipped, ErosionMaker::GetPacketInstructionSet());
+
+	erosionMaker->parameters = parameters;
+	return failures == 0;
+}
+
+void ErosionVerification::PrintGoldenHashes(FILE* out)
+{
+	ErosionParameters parameters = erosionMaker->parameters;
+
+	std::vector<float> reference;
+	for (const VerificationCase& verificationCase : verificationCases)
+	{
+		Erode(erosionMaker, &reference, verificationCase, referenceVariant);
+		fprintf(out, "\t{ %d, %d, %d, %d, 0x%016llxull },\n", verificationCase.mapWidth, verificationCase.mapHeight, verificationCase.radius, verificationCase.droplets, HashMap(reference));
+	}
+
+	erosionMaker->parameters = parameters;
+}
@@ -0,0 +1,61 @@
+#ifndef EROSION_VERIFICATION
+#define EROSION_VERIFICATION
+
+#include <stdio.h>
+#include <vector>
+#include "ErosionMaker.h"
+
+// configuration of the droplet kernel checked against the reference (scalar kernel, row-major, one thread, one Erode call)
+typedef struct
+{
+	const char* name;
+	ErosionKernel kernel;
+	HeightmapLayout layout;
+	int threads; // threadCount of the erosion maker
+	bool incremental; // runs through StartErode / ContinueErode, which splits the droplets in timed batches
+	bool exact; // promised to give the reference heightmap bit for bit
+} ErosionVariant;
+
+// a map, brush and droplet count of the verification matrix with the hash of the reference result
+typedef struct
+{
+	int mapWidth;
+	int mapHeight;
+	int radius;
+	int droplets;
+	unsigned long long goldenHash; // FNV-1a of the heights eroded by the reference kernel, 0 = not recorded yet
+} VerificationCase;
+
+// checks that the droplet kernels still erode the way they used to: the reference kernel against hashes recorded in
+// the source (golden outputs), every variant against the reference (bit for bit where the result is promised not to
+// change, within a tolerance elsewhere, two instances eroding at once included) and every result for mass: droplets
+// only move material, they can't create any. the fused island shaping is checked against the passes it replaces, normal
+// maps against GetNormal, the lookup tables of remap curves against their curves and the SIMD noise against its scalar cells.
+// the maps are built with arithmetic only (no libm) so the hashes hold across compilers with IEEE floats and no FMA contraction
+// (turned off by FloatContract.h, the packet checks are skipped when the packet kernel would run the scalar one)
+class ErosionVerification
+{
+public:
+	ErosionVerification(ErosionMaker* erosionMaker) : erosionMaker(erosionMaker) {}
+
+	bool Run(FILE* report); // runs the whole matrix, a line per check, returns true when every check that ran passed (skipped ones don't fail)
+	void PrintGoldenHashes(FILE* out); // prints the case table with the hashes of this build, to record new golden outputs
+
+	static const unsigned int SEED = 20200601; // droplet seed of every case
+	static constexpr double MAX_RMS_RATIO = 0.5; // inexact variants: RMS difference to the reference over RMS of the reference erosion
+	static constexpr double MAX_REMOVED_DIFFERENCE = 0.1; // inexact variants: relative difference of the material lost with the reference
+	static constexpr double MASS_TOLERANCE = 1e-4; // relative to the total height, absorbs float rounding of the sums
+	static constexpr float NORMAL_TOLERANCE = 1.0f / 127.5f; // normal maps: largest difference of a component to GetNormal, a step of the 8 bit texels
+	static constexpr float REMAP_TABLE_TOLERANCE = 2e-4f; // remap tables: largest difference to the curve (at kinks), about 13 steps of a 16 bit height
+	static constexpr float MIN_NOISE_RANGE = 0.25f; // noise: smallest spread of the heights of a map, catches a generator gone flat
+
+	static void GenerateMap(std::vector<float>* map, int mapWidth, int mapHeight); // value noise island, identical on every platform
+	static unsigned long long HashMap(const std::vector<float>& map);
+
+private:
+	ErosionMaker* erosionMaker;
+
+	void Erode(ErosionMaker* maker, std::vector<float>* map, const VerificationCase& verificationCase, const ErosionVariant& variant);
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include "ErosionWorker.h"
+#include <algorithm>
+#include <chrono>
+
+ErosionWorker::ErosionWorker(ErosionMaker* erosionMaker, const std::vector<float>& map, int mapWidth, int mapHeight)
+	: erosionMaker(erosionMaker), mapWidth(mapWidth), mapHeight(mapHeight), map(map)
+{
+	state.totalDroplets = 0;
+	state.totalPipeIterations = 0;
+	state.mapGeneration = 0;
+	state.jobsDone = 0;
+	state.lastJob = { ErosionJobType::ERODE, 0, erosionMaker->parameters.model, erosionMaker->parameters.kernel };
+	state.lastJobSeconds = 0.0f;
+	state.lastJobDropletsPerSecond = 0.0f;
+	state.jobRunning = false;
+	state.jobProgress = 0.0f;
+	state.version = 0;
+	size_t tileCount = (size_t)ErosionMaker::GetDirtyTileCount(mapWidth) * ErosionMaker::GetDirtyTileCount(mapHeight);
+	state.tileVersions.assign(tileCount, 0);
+	for (int i = 0; i < 3; i++)
+	{
+		buffers[i] = state; // state.map stays empty, the map lives in map
+		buffers[i].tileVersions.clear(); // copied on publish
+	}
+	buffers[frontIndex].map = map; // the reader starts with the initial map
+	buffers[frontIndex].tileVersions = state.tileVersions;
+	middle = 2;
+	requestedModel = (int)erosionMaker->parameters.model;
+	requestedKernel = (int)erosionMaker->parameters.kernel;
+
+	thread = std::thread(&ErosionWorker::WorkerLoop, this);
+}
+
+ErosionWorker::~ErosionWorker()
+{
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		quit = true;
+	}
+	requestAdded.notify_one();
+	thread.join();
+}
+
+void ErosionWorker::QueueJob(ErosionJobType type, int iterations)
+{
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		jobs.push_back({ type, iterations, GetModel(), GetKernel() });
+	}
+	requestAdded.notify_one();
+}
+
+void ErosionWorker::SetContinuous(bool erode)
+{
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		if (continuous == erode)
+			return;
+		continuous = erode;
+	}
+	requestAdded.notify_one();
+}
+
+void ErosionWorker::Reset(const std::vector<float>& newMap)
+{
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		jobs.clear();
+		resetMap = newMap;
+		resetShapesIsland = false;
+		resetPending = true;
+		erosionMaker->CancelErode(); // don't wait for the end of the running slice (under the lock, so it can't hit a job started after the reset)
+	}
+	requestAdded.notify_one();
+}
+
+void ErosionWorker::ResetIsland(GradientType gradientType)
+{
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		jobs.clear();
+		resetGradient = gradientType;
+		resetShapesIsland = true;
+		resetPending = true;
+		erosionMaker->CancelErode();
+	}
+	requestAdded.notify_one();
+}
+
+void ErosionWorker::SetIslandNoise(std::vector<float> noise)
+{
+	std::lock_guard<std::mutex> lock(requestMutex);
+	islandNoise.swap(noise);
+}
+
+void ErosionWorker::CancelJobs()
+{
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		jobs.clear();
+		cancelPending = true;
+		erosionMaker->CancelErode();
+	}
+	requestAdded.notify_one();
+}
+
+bool ErosionWorker::IsBusy()
+{
+	std::lock_guard<std::mutex> lock(requestMutex);
+	return running || resetPending || !jobs.empty();
+}
+
+bool ErosionWorker::AcquireLatest()
+{
+	if ((middle.load(std::memory_order_acquire) & FRESH) == 0)
+		return false;
+	// give the old front buffer to the worker, take the fresh one
+	frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & ~FRESH;
+	return true;
+}
+
+void ErosionWorker::Publish()
+{
+	// stamp the tiles changed since the last publish with the new version
+	state.version++;
+	erosionMaker->TakeDirtyTiles(&dirtyTiles, mapWidth, mapHeight);
+	for (size_t tile = 0; tile < state.tileVersions.size(); tile++)
+	{
+		if (resetDirty || ((dirtyTiles[tile >> 6] >> (tile & 63)) & 1))
+			state.tileVersions[tile] = state.version;
+	}
+	resetDirty = false;
+
+	ErosionSnapshot& back = buffers[backIndex];
+	if (back.map.size() != map.size())
+		back.map.assign(map.begin(), map.end()); // first publish into this buffer
+	else
+		CopyChangedTiles(&back.map, back.version); // the buffer holds the map of its last publish, only newer tiles differ
+	back.totalDroplets = state.totalDroplets;
+	back.totalPipeIterations = state.totalPipeIterations;
+	back.mapGeneration = state.mapGeneration;
+	back.jobsDone = state.jobsDone;
+	back.lastJob = state.lastJob;
+	back.lastJobSeconds = state.lastJobSeconds;
+	back.lastJobDropletsPerSecond = state.lastJobDropletsPerSecond;
+	back.lastJobStatistics = state.lastJobStatistics;
+	back.jobRunning = state.jobRunning;
+	back.jobProgress = state.jobProgress;
+	back.version = state.version;
+	back.tileVersions.assign(state.tileVersions.begin(), state.tileVersions.end());
+	// the buffer in the middle becomes the next back buffer, whether the reader took the previous state or not
+	backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+void ErosionWorker::CopyChangedTiles(std::vector<float>* target, unsigned int targetVersion)
+{
+	// one run of changed tiles in a tile row at a time, row by row
+	const int tileSize = ErosionMaker::DIRTY_TILE_SIZE;
+	int tileColumns = ErosionMaker::GetDirtyTileCount(mapWidth);
+	int tileRows = ErosionMaker::GetDirtyTileCount(mapHeight);
+	for (int tileY = 0; tileY < tileRows; tileY++)
+	{
+		for (int tileX = 0; tileX < tileColumns; tileX++)
+		{
+			if (state.tileVersions[(size_t)tileY * tileColumns + tileX] <= targetVersion)
+				continue;
+			int runEnd = tileX + 1;
+			while (runEnd < tileColumns && state.tileVersions[(size_t)tileY * tileColumns + runEnd] > targetVersion)
+				runEnd++;
+			int x = tileX * tileSize;
+			int width = std::min(runEnd * tileSize, mapWidth) - x;
+			int endY = std::min((tileY + 1) * tileSize, mapHeight);
+			for (int y = tileY * tileSize; y < endY; y++)
+			{
+				size_t start = (size_t)y * mapWidth + x;
+				std::copy(map.begin() + start, map.begin() + start + width, target->begin() + start);
+			}
+			tileX = runEnd;
+		}
+	}
+}
+
+bool ErosionWorker::RunSlice(const ErosionJob& job, bool start)
+{
+	const float sliceSeconds = SLICE_MS / 1000.0f;
+	if (start)
+	{
+		erosionMaker->parameters.model = job.model;
+		erosionMaker->parameters.kernel = job.kernel;
+		erosionMaker->ResetDropletStatistics();
+		jobDone = 0;
+	}
+
+	if (job.type == ErosionJobType::THERMAL)
+	{
+		// thermal iterations are cheap and regular, run them one by one until the slice is over
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		do
+		{
+			erosionMaker->ErodeThermal(&map, mapWidth, mapHeight, 1);
+			jobDone++;
+		} while (jobDone < job.iterations && std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(SLICE_MS));
+		return jobDone >= job.iterations;
+	}
+
+	if (job.type == ErosionJobType::MULTIRESOLUTION)
+	{
+		// the pyramid isn't sliced, its coarse levels are short and the full map level checks for cancellation between batches
+		ErosionProgress progress = erosionMaker->ErodeMultiresolution(&map, mapWidth, mapHeight, job.iterations);
+		if (!progress.cancelled)
+			jobDone = job.iterations;
+		state.totalDroplets += (int)progress.done;
+		return true;
+	}
+
+	if (start)
+		erosionMaker->StartErode(job.iterations); // 0 iterations (continuous erosion) runs until the job is dropped
+	ErosionProgress progress = erosionMaker->ContinueErode(&map, mapWidth, mapHeight, sliceSeconds);
+	int simulated = (int)(progress.done - jobDone);
+	jobDone = progress.done;
+	if (job.model == ErosionModel::PIPES)
+		state.totalPipeIterations += simulated;
+	else
+		state.totalDroplets += simulated;
+	return progress.finished;
+}
+
+void ErosionWorker::WorkerLoop()
+{
+	ErosionJob job;
+	bool jobActive = false; // job has been started and isn't finished
+	bool queued = false; // job was queued (not continuous erosion)
+	float jobSeconds = 0.0f;
+
+	while (true)
+	{
+		bool start = false;
+		{
+			std::unique_lock<std::mutex> lock(requestMutex);
+			running = false;
+			requestAdded.wait(lock, [this, jobActive] { return quit || resetPending || cancelPending || !jobs.empty() || continuous || jobActive; });
+			if (quit)
+				return;
+
+			if (resetPending || cancelPending)
+			{
+				jobActive = false;
+				cancelPending = false;
+				state.jobRunning = false;
+				state.jobProgress = 0.0f;
+				bool shapeIsland = false;
+				GradientType gradientType = resetGradient;
+				if (resetPending)
+				{
+					shapeIsland = resetShapesIsland;
+					if (!shapeIsland)
+						map.swap(resetMap);
+					resetPending = false;
+					erosionMaker->ResetPipeState(); // water and sediment belong to the old map
+					state.totalDroplets = 0;
+					state.totalPipeIterations = 0;
+					state.mapGeneration++;
+					resetDirty = true;
+				}
+				running = true; // busy until the new map is published
+				lock.unlock();
+				// a whole map pass, out of the lock so the render loop can still send requests meanwhile
+				if (shapeIsland)
+					erosionMaker->ShapeIsland(islandNoise.data(), map.data(), nullptr, mapWidth, mapHeight, gradientType);
+				Publish();
+				continue;
+			}
+
+			// continuous erosion gives way to queued jobs and stops when it's no longer requested
+			if (jobActive && !queued && (!continuous || !jobs.empty()))
+				jobActive = false;
+			if (!jobActive)
+			{
+				if (!jobs.empty())
+				{
+					job = jobs.front();
+					jobs.pop_front();
+					queued = true;
+				}
+				else if (continuous)
+				{
+					job = { ErosionJobType::ERODE, 0, GetModel(), GetKernel() };
+					queued = false;
+				}
+				else
+				{
+					continue;
+				}
+				erosionMaker->ClearCancel(); // under the lock of Reset and CancelJobs, a cancel issued from now on stops this job
+				jobActive = true;
+				start = true;
+				jobSeconds = 0.0f;
+			}
+			running = true;
+		}
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		bool finished = RunSlice(job, start);
+		jobSeconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count() / 1000000000.0f;
+
+		if (finished)
+		{
+			jobActive = false;
+			if (queued && jobDone >= job.iterations)
+			{
+				// report of the finished job (cancelled ones are dropped silently)
+				state.jobsDone++;
+				state.lastJob = job;
+				state.lastJobSeconds = jobSeconds;
+				state.lastJobDropletsPerSecond = (jobSeconds > 0.0f) ? job.iterations / jobSeconds : 0.0f;
+				state.lastJobStatistics = erosionMaker->GetDropletStatistics();
+			}
+		}
+		state.jobRunning = jobActive && queued;
+		state.jobProgress = state.jobRunning ? (float)jobDone / job.iterations : 0.0f;
+		Publish();
+	}
+}
@@ -0,0 +1,122 @@
+#ifndef EROSION_WORKER
+#define EROSION_WORKER
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ErosionMaker.h"
+
+// kind of work requested to the erosion worker
+enum ErosionJobType
+{
+	ERODE = 0, // Erode with the current model (droplets or pipe iterations)
+	THERMAL = 1, // ErodeThermal iterations
+	MULTIRESOLUTION = 2, // ErodeMultiresolution with iterations droplets on the full map, in a single slice
+};
+
+// batch of work requested to the erosion worker
+typedef struct
+{
+	ErosionJobType type;
+	int iterations;
+	ErosionModel model; // settings of the erosion maker when the batch was requested
+	ErosionKernel kernel;
+} ErosionJob;
+
+// heightmap state published by the erosion worker
+typedef struct
+{
+	std::vector<float> map;
+	int totalDroplets; // droplets simulated since the map was last reset
+	int totalPipeIterations; // virtual pipe iterations simulated since the map was last reset
+	unsigned int mapGeneration; // incremented every time the map is reset
+	unsigned int jobsDone; // incremented every time a queued job finishes, lastJob describes it
+	ErosionJob lastJob;
+	float lastJobSeconds;
+	float lastJobDropletsPerSecond;
+	DropletStatistics lastJobStatistics; // what the droplets of lastJob did (coarse levels included for MULTIRESOLUTION)
+	bool jobRunning; // a queued job was running when the state was published
+	float jobProgress; // range (0, 1) part of the running queued job done
+	unsigned int version; // incremented on every publish
+	std::vector<unsigned int> tileVersions; // version that last changed each dirty tile of the map (ErosionMaker::DIRTY_TILE_SIZE, row-major)
+} ErosionSnapshot;
+
+// runs the erosion maker on a persistent background thread, on a private copy of the heightmap.
+// jobs run in slices of a fixed time budget (ContinueErode for droplets and pipes), every slice is published,
+// so long batches show their progress and can be cancelled or replaced by a reset within a slice.
+// finished states are published through a lock-free triple buffer: the worker fills a back buffer and exchanges it with
+// the middle one, the render loop exchanges its front buffer with the middle one when a new state is there, nobody waits.
+// a buffer keeps the map of its last publish, so filling it again only copies the tiles changed since (tileVersions)
+// while the worker exists it is the only user of the erosion maker's simulation (Erode, ErodeThermal, ResetPipeState, ShapeIsland)
+class ErosionWorker
+{
+public:
+	ErosionWorker(ErosionMaker* erosionMaker, const std::vector<float>& map, int mapWidth, int mapHeight); // starts the thread on a copy of map
+	~ErosionWorker(); // waits for the running batch and stops the thread
+
+	ErosionWorker(ErosionWorker const&) = delete;
+	void operator=(ErosionWorker const&) = delete;
+
+	void QueueJob(ErosionJobType type, int iterations); // adds a batch to run after the ones already queued
+	void SetContinuous(bool erode); // while true, the worker keeps eroding small batches when it has nothing queued
+	void Reset(const std::vector<float>& map); // cancels all batches and restarts from map
+	void ResetIsland(GradientType gradientType); // same with the island ShapeIsland makes of the noise of SetIslandNoise, shaped on the worker thread
+	void SetIslandNoise(std::vector<float> noise); // base heights of ResetIsland, set once before the first ResetIsland
+	void CancelJobs(); // cancels the running batch and drops the queued ones, the map keeps the work already done
+	void SetModel(ErosionModel model) { requestedModel = (int)model; } // applies to batches requested from now on
+	void SetKernel(ErosionKernel kernel) { requestedKernel = (int)kernel; }
+	ErosionModel GetModel() const { return (ErosionModel)requestedModel.load(); }
+	ErosionKernel GetKernel() const { return (ErosionKernel)requestedKernel.load(); }
+	bool IsBusy(); // true while batches are queued or running
+
+	bool AcquireLatest(); // makes the newest published state the snapshot, returns false if nothing new was published
+	ErosionSnapshot* GetSnapshot() { return &buffers[frontIndex]; } // owned by the caller until the next AcquireLatest
+
+	static const int SLICE_MS = 15; // time budget of a slice of work, a state is published after every slice
+
+private:
+	void WorkerLoop();
+	bool RunSlice(const ErosionJob& job, bool start); // runs a slice of the job, returns true when the job is finished
+	void Publish();
+	void CopyChangedTiles(std::vector<float>* target, unsigned int targetVersion); // copies the tiles of map changed after targetVersion
+
+	ErosionMaker* erosionMaker;
+	int mapWidth;
+	int mapHeight;
+	std::thread thread;
+
+	// worker side state, only touched by the worker thread
+	std::vector<float> map;
+	ErosionSnapshot state; // counters of map, copied into the buffers on publish (map excluded)
+	int backIndex = 1;
+	std::vector<unsigned long long> dirtyTiles; // scratch for the tiles changed since the last publish
+	bool resetDirty = false; // the whole map changed since the last publish
+	long long jobDone = 0; // iterations of the running job already simulated
+
+	// triple buffer, middle holds the index of the buffer in the middle plus FRESH when it wasn't acquired yet
+	static const int FRESH = 4;
+	ErosionSnapshot buffers[3];
+	std::atomic<int> middle;
+	int frontIndex = 0; // only touched by the reader
+
+	// requests from the render loop
+	std::mutex requestMutex;
+	std::condition_variable requestAdded;
+	std::deque<ErosionJob> jobs;
+	std::vector<float> resetMap;
+	std::vector<float> islandNoise; // not changed once a ResetIsland was requested, the worker reads it without the lock
+	GradientType resetGradient = GradientType::SQUARE;
+	bool resetPending = false;
+	bool resetShapesIsland = false; // the pending reset shapes the island instead of taking resetMap
+	bool cancelPending = false;
+	bool continuous = false;
+	bool running = false;
+	bool quit = false;
+	std::atomic<int> requestedModel;
+	std::atomic<int> requestedKernel;
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef FLOAT_CONTRACT
+#define FLOAT_CONTRACT
+
+// turns FMA contraction off for the rest of the file, included first so the inline functions of the headers are covered
+// too. a fused multiply-add rounds once instead of twice, which changes the eroded maps bit for bit, so the erosion,
+// island, noise and remap sources behind the golden outputs of ErosionVerification include it, and nothing else.
+// gcc and clang contract by default as soon as the target has FMA (-march=native), MSVC doesn't under /fp:precise
+// (terrain_generator.vcxproj). builds passing -ffp-contract=off themselves don't need it
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#endif
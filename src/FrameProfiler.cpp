@@ -0,0 +1,204 @@
+#include "FrameProfiler.h"
+#include "raylib.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#define OVERLAY_FONT_SIZE	10
+#define OVERLAY_ROW_HEIGHT	12
+#define OVERLAY_NAME_WIDTH	200
+#define OVERLAY_BAR_WIDTH	160
+
+FrameProfiler::FrameProfiler()
+{
+	start = std::chrono::steady_clock::now();
+	frames.resize(FRAME_HISTORY);
+}
+
+long long FrameProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int FrameProfiler::GetZoneIndex(const char* name)
+{
+	// names are literals, the same zone nearly always passes the same pointer
+	for (size_t i = 0; i < zoneNames.size(); i++)
+	{
+		if (zoneNames[i] == name)
+			return (int)i;
+	}
+	for (size_t i = 0; i < zoneNames.size(); i++)
+	{
+		if (strcmp(zoneNames[i], name) == 0)
+			return (int)i;
+	}
+	zoneNames.push_back(name);
+	zoneDepths.push_back(openCount);
+	return (int)zoneNames.size() - 1;
+}
+
+void FrameProfiler::BeginFrame()
+{
+	if (currentFrame >= 0)
+		EndFrame();
+	currentFrame = nextFrame;
+	nextFrame = (nextFrame + 1) % FRAME_HISTORY;
+	ProfiledFrame& frame = frames[currentFrame];
+	frame.beginNs = Now();
+	frame.durationNs = 0;
+	frame.zoneCount = 0;
+	openCount = 0;
+	droppedZones = 0;
+}
+
+void FrameProfiler::EndFrame()
+{
+	if (currentFrame < 0)
+		return;
+	while (openCount > 0)
+		EndZone(); // zones left open end with the frame
+	ProfiledFrame& frame = frames[currentFrame];
+	frame.durationNs = Now() - frame.beginNs;
+	recordedFrames = std::min(recordedFrames + 1, FRAME_HISTORY);
+	currentFrame = -1;
+}
+
+void FrameProfiler::BeginZone(const char* name)
+{
+	if (currentFrame < 0)
+		return;
+	ProfiledFrame& frame = frames[currentFrame];
+	if (droppedZones > 0 || frame.zoneCount >= MAX_FRAME_ZONES || openCount >= MAX_DEPTH)
+	{
+		droppedZones++; // nested zones of a dropped zone are dropped too, so EndZone calls still pair up
+		return;
+	}
+	ProfiledZone& zone = frame.zones[frame.zoneCount];
+	zone.zone = GetZoneIndex(name);
+	zone.depth = openCount;
+	zone.durationNs = 0;
+	openZones[openCount++] = frame.zoneCount++;
+	zone.beginNs = Now() - frame.beginNs; // last, so the bookkeeping isn't timed
+}
+
+void FrameProfiler::EndZone()
+{
+	if (currentFrame < 0)
+		return;
+	if (droppedZones > 0)
+	{
+		droppedZones--;
+		return;
+	}
+	if (openCount == 0)
+		return;
+	ProfiledFrame& frame = frames[currentFrame];
+	ProfiledZone& zone = frame.zones[openZones[--openCount]];
+	zone.durationNs = Now() - frame.beginNs - zone.beginNs;
+}
+
+int FrameProfiler::GetCompletedFrameCount()
+{
+	// the frame being recorded took the slot of the oldest one
+	return (currentFrame >= 0) ? std::min(recordedFrames, FRAME_HISTORY - 1) : recordedFrames;
+}
+
+const ProfiledFrame& FrameProfiler::GetCompletedFrame(int age)
+{
+	int newest = (currentFrame >= 0) ? currentFrame - 1 : nextFrame - 1;
+	return frames[(newest - age + 2 * FRAME_HISTORY) % FRAME_HISTORY];
+}
+
+std::vector<ZoneSummary> FrameProfiler::GetSummary(double* averageFrameMs, double* maxFrameMs)
+{
+	std::vector<ZoneSummary> summary(zoneNames.size());
+	for (size_t i = 0; i < zoneNames.size(); i++)
+	{
+		summary[i] = { zoneNames[i], zoneDepths[i], 0.0, 0.0 };
+	}
+	std::vector<double> frameMs(zoneNames.size());
+	double totalMs = 0.0;
+	*maxFrameMs = 0.0;
+	int frameCount = GetCompletedFrameCount();
+	for (int age = 0; age < frameCount; age++)
+	{
+		const ProfiledFrame& frame = GetCompletedFrame(age);
+		std::fill(frameMs.begin(), frameMs.end(), 0.0);
+		for (int zone = 0; zone < frame.zoneCount; zone++)
+		{
+			frameMs[frame.zones[zone].zone] += frame.zones[zone].durationNs / 1000000.0; // a zone may run several times per frame
+		}
+		for (size_t zone = 0; zone < summary.size(); zone++)
+		{
+			summary[zone].averageMs += frameMs[zone];
+			summary[zone].maxMs = std::max(summary[zone].maxMs, frameMs[zone]);
+		}
+		totalMs += frame.durationNs / 1000000.0;
+		*maxFrameMs = std::max(*maxFrameMs, frame.durationNs / 1000000.0);
+	}
+	for (ZoneSummary& zone : summary)
+	{
+		zone.averageMs /= std::max(frameCount, 1);
+	}
+	*averageFrameMs = totalMs / std::max(frameCount, 1);
+	return summary;
+}
+
+void FrameProfiler::DrawOverlay(int x, int y, float budgetMs)
+{
+	double averageFrameMs, maxFrameMs;
+	std::vector<ZoneSummary> summary = GetSummary(&averageFrameMs, &maxFrameMs);
+	int rows = (int)summary.size() + 2;
+	int width = OVERLAY_NAME_WIDTH + OVERLAY_BAR_WIDTH + 20;
+	DrawRectangle(x, y, width, rows * OVERLAY_ROW_HEIGHT + 8, Fade(BLACK, 0.6f));
+	x += 4;
+	y += 4;
+	DrawText(TextFormat("CPU ms per frame, last %i frames    avg / max", GetCompletedFrameCount()), x, y, OVERLAY_FONT_SIZE, WHITE);
+	y += OVERLAY_ROW_HEIGHT;
+
+	// bars show the average, the thin mark the worst frame, the budget is the right end of the bar area
+	float pixelsPerMs = OVERLAY_BAR_WIDTH / budgetMs;
+	int barX = x + OVERLAY_NAME_WIDTH;
+	for (int row = 0; row <= (int)summary.size(); row++)
+	{
+		bool frameRow = row == (int)summary.size();
+		const char* name = frameRow ? "frame" : summary[row].name;
+		int depth = frameRow ? 0 : summary[row].depth;
+		double averageMs = frameRow ? averageFrameMs : summary[row].averageMs;
+		double maxMs = frameRow ? maxFrameMs : summary[row].maxMs;
+		Color color = (maxMs > budgetMs) ? RED : (frameRow ? YELLOW : WHITE);
+		DrawText(TextFormat("%*s%s", depth * 2, "", name), x, y, OVERLAY_FONT_SIZE, color);
+		DrawText(TextFormat("%6.2f / %6.2f", averageMs, maxMs), barX - 84, y, OVERLAY_FONT_SIZE, color);
+		int barLength = (int)std::min(averageMs * pixelsPerMs, (double)OVERLAY_BAR_WIDTH);
+		DrawRectangle(barX, y + 2, barLength, OVERLAY_ROW_HEIGHT - 4, Fade(color, 0.7f));
+		int maxMark = (int)std::min(maxMs * pixelsPerMs, (double)OVERLAY_BAR_WIDTH);
+		DrawRectangle(barX + maxMark - 1, y + 1, 2, OVERLAY_ROW_HEIGHT - 2, color);
+		y += OVERLAY_ROW_HEIGHT;
+	}
+	DrawRectangleLines(barX + OVERLAY_BAR_WIDTH, y - rows * OVERLAY_ROW_HEIGHT + OVERLAY_ROW_HEIGHT, 1, (rows - 1) * OVERLAY_ROW_HEIGHT, GRAY);
+}
+
+bool FrameProfiler::WriteChromeTrace(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == nullptr)
+		return false;
+
+	// complete ("X") events with microsecond timestamps, the frame as the outermost event of every frame
+	fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	fprintf(file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"render loop\"}}");
+	for (int age = GetCompletedFrameCount() - 1; age >= 0; age--)
+	{
+		const ProfiledFrame& frame = GetCompletedFrame(age);
+		fprintf(file, ",\n{\"name\": \"frame\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"dur\": %.3f}", frame.beginNs / 1000.0, frame.durationNs / 1000.0);
+		for (int zone = 0; zone < frame.zoneCount; zone++)
+		{
+			const ProfiledZone& event = frame.zones[zone];
+			fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"dur\": %.3f}",
+				zoneNames[event.zone], (frame.beginNs + event.beginNs) / 1000.0, event.durationNs / 1000.0);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
@@ -0,0 +1,96 @@
+#ifndef FRAME_PROFILER
+#define FRAME_PROFILER
+
+#include <chrono>
+#include <vector>
+
+// a timed zone of a frame, nested zones follow their parent
+typedef struct
+{
+	int zone; // index in the zone names
+	int depth; // number of zones open when it started
+	long long beginNs; // since the start of the frame
+	long long durationNs;
+} ProfiledZone;
+
+// a frame of the ring buffer
+typedef struct
+{
+	long long beginNs; // since the profiler was created
+	long long durationNs;
+	int zoneCount; // zones recorded, at most MAX_FRAME_ZONES
+	ProfiledZone zones[64]; // FrameProfiler::MAX_FRAME_ZONES, checked at the end of the file
+} ProfiledFrame;
+
+// timing summary of a zone over the frames kept in the ring buffer
+typedef struct
+{
+	const char* name;
+	int depth; // nesting of the zone the first time it was seen, used to indent the overlay
+	double averageMs; // per frame, frames without the zone count as 0
+	double maxMs;
+} ZoneSummary;
+
+// CPU profiler of the render loop: frames are split in named scoped zones whose timings are kept for the last
+// FRAME_HISTORY frames, shown as a breakdown overlay and exported as Chrome trace events (chrome://tracing, Perfetto).
+// zones measure the time spent by the calling thread: GPU work is asynchronous, it shows up where the driver
+// waits for it (usually EndDrawing). only the render thread records zones, the erosion worker has its own timings
+class FrameProfiler
+{
+public:
+	static FrameProfiler& GetInstance()
+	{
+		static FrameProfiler instance; // shared by every module, created on first use
+		return instance;
+	}
+
+	FrameProfiler(FrameProfiler const&) = delete;
+	void operator=(FrameProfiler const&) = delete;
+
+	void BeginFrame(); // starts recording a frame, closes the previous one if EndFrame wasn't called
+	void EndFrame();
+	void BeginZone(const char* name); // name must outlive the profiler (a literal), zones outside a frame are ignored
+	void EndZone(); // closes the last zone begun
+
+	std::vector<ZoneSummary> GetSummary(double* averageFrameMs, double* maxFrameMs); // zones in the order they were first seen
+	void DrawOverlay(int x, int y, float budgetMs); // breakdown of the frame by zone with bars relative to budgetMs
+	bool WriteChromeTrace(const char* path); // Chrome trace event JSON of the frames in the ring buffer, false if it can't be written
+
+	static const int FRAME_HISTORY = 240; // frames kept in the ring buffer
+	static const int MAX_FRAME_ZONES = 64; // zones recorded per frame (size of ProfiledFrame::zones), later ones are dropped
+	static const int MAX_DEPTH = 16; // zones open at once
+
+private:
+	FrameProfiler();
+
+	long long Now(); // nanoseconds since the profiler was created
+	int GetZoneIndex(const char* name);
+	int GetCompletedFrameCount(); // frames of the ring buffer that were ended
+	const ProfiledFrame& GetCompletedFrame(int age); // 0 = the last frame ended
+
+	std::chrono::steady_clock::time_point start;
+	std::vector<ProfiledFrame> frames; // ring buffer
+	int currentFrame = -1; // frame being recorded, -1 = none
+	int nextFrame = 0; // slot of the next frame
+	int recordedFrames = 0; // frames completed in the ring buffer, up to FRAME_HISTORY
+	std::vector<const char*> zoneNames;
+	std::vector<int> zoneDepths;
+	int openZones[MAX_DEPTH]; // indices in the current frame of the zones not ended yet
+	int openCount = 0;
+	int droppedZones = 0; // zones begun past MAX_FRAME_ZONES or MAX_DEPTH in the current frame, their EndZone is ignored
+};
+
+// times the enclosing scope as a zone of the frame profiler
+class ProfileZone
+{
+public:
+	ProfileZone(const char* name) { FrameProfiler::GetInstance().BeginZone(name); }
+	~ProfileZone() { FrameProfiler::GetInstance().EndZone(); }
+
+	ProfileZone(ProfileZone const&) = delete;
+	void operator=(ProfileZone const&) = delete;
+};
+
+static_assert(sizeof(ProfiledFrame::zones) / sizeof(ProfiledZone) == FrameProfiler::MAX_FRAME_ZONES, "ProfiledFrame::zones must hold MAX_FRAME_ZONES zones");
+
+#endif
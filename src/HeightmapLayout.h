@@ -0,0 +1,74 @@
+#ifndef HEIGHTMAP_LAYOUT
+#define HEIGHTMAP_LAYOUT
+
+#include <cstddef>
+
+// storage order of the heights of a map
+enum HeightmapLayout
+{
+	ROW_MAJOR = 0, // y * width + x, the layout of every map passed to ErosionMaker and uploaded to the GPU
+	TILED = 1, // blocks of cells in Z-order, see TiledLayout
+};
+
+// cell addressing of a row-major map
+typedef struct RowMajorLayout
+{
+	int width;
+
+	RowMajorLayout(int mapWidth) : width(mapWidth) {}
+	size_t Index(int x, int y) const { return (size_t)y * width + x; }
+} RowMajorLayout;
+
+// cell addressing of a map stored in square blocks of BLOCK_SIZE cells: blocks are in row-major order, the cells of a block
+// in Z-order (Morton order), so cells close on the map are close in memory on both axes.
+// a brush of radius 6 touches at most 4 blocks (16 KB apart at most) where rows touch 13 lines a row apart
+// the last block row and column are padded up to a whole block, the padding is never read
+typedef struct TiledLayout
+{
+	static const int BLOCK_BITS = 4;
+	static const int BLOCK_SIZE = 1 << BLOCK_BITS; // 16 x 16 cells, 1 KB of heights
+	static const int BLOCK_CELLS = BLOCK_SIZE * BLOCK_SIZE;
+
+	int blockColumns;
+	int blockRows;
+
+	TiledLayout(int mapWidth, int mapHeight) : blockColumns((mapWidth + BLOCK_SIZE - 1) / BLOCK_SIZE), blockRows((mapHeight + BLOCK_SIZE - 1) / BLOCK_SIZE) {}
+
+	size_t Index(int x, int y) const
+	{
+		size_t block = (size_t)(y >> BLOCK_BITS) * blockColumns + (x >> BLOCK_BITS);
+		return block * BLOCK_CELLS + (Spread(x & (BLOCK_SIZE - 1)) | (Spread(y & (BLOCK_SIZE - 1)) << 1));
+	}
+	size_t GetSize() const { return (size_t)blockColumns * blockRows * BLOCK_CELLS; } // heights to allocate, padding included
+
+	// spreads the 4 bits of a coordinate inside a block to the even bits of the Morton code
+	static int Spread(int value)
+	{
+		static const unsigned char spread[BLOCK_SIZE] = { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15, 0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55 };
+		return spread[value];
+	}
+
+	// converts the rectangle from (minX, minY) to (maxX, maxY) excluded between a row-major map and a tiled one
+	void FromRowMajor(const float* rows, float* tiles, int mapWidth, int minX, int minY, int maxX, int maxY) const
+	{
+		for (int y = minY; y < maxY; y++)
+		{
+			const float* row = rows + (size_t)y * mapWidth;
+			float* blocks = tiles + Index(0, y);
+			for (int x = minX; x < maxX; x++)
+				blocks[(size_t)(x >> BLOCK_BITS) * BLOCK_CELLS + Spread(x & (BLOCK_SIZE - 1))] = row[x];
+		}
+	}
+	void ToRowMajor(const float* tiles, float* rows, int mapWidth, int minX, int minY, int maxX, int maxY) const
+	{
+		for (int y = minY; y < maxY; y++)
+		{
+			float* row = rows + (size_t)y * mapWidth;
+			const float* blocks = tiles + Index(0, y);
+			for (int x = minX; x < maxX; x++)
+				row[x] = blocks[(size_t)(x >> BLOCK_BITS) * BLOCK_CELLS + Spread(x & (BLOCK_SIZE - 1))];
+		}
+	}
+} TiledLayout;
+
+#endif
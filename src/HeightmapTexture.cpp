@@ -0,0 +1,172 @@
+#include "HeightmapTexture.h"
+#include "rlgl.h"
+#include "ErosionMaker.h"
+#include <string.h>
+#include <algorithm>
+
+// packs the texels of a rect of the normal map row after row
+static void CopyNormalRows(const NormalMap& normals, const NormalRect& rect, unsigned char* destination)
+{
+	size_t rowBytes = (size_t)rect.width * NormalMap::TEXEL_BYTES;
+	for (int y = 0; y < rect.height; y++)
+	{
+		const unsigned char* row = normals.GetTexels() + ((size_t)(rect.y + y) * normals.GetWidth() + rect.x) * NormalMap::TEXEL_BYTES;
+		memcpy(destination + y * rowBytes, row, rowBytes);
+	}
+}
+
+HeightmapTexture::HeightmapTexture(const std::vector<float>& map, int mapWidth, int mapHeight)
+	: normals(mapWidth, mapHeight), mapWidth(mapWidth), mapHeight(mapHeight)
+{
+	values.resize((size_t)mapWidth * mapHeight);
+	ErosionMaker::EncodeHeights(map.data(), values.data(), (int)values.size());
+	Load(map);
+}
+
+HeightmapTexture::HeightmapTexture(const std::vector<float>& map, const std::vector<unsigned short>& encodedValues, int mapWidth, int mapHeight)
+	: normals(mapWidth, mapHeight), mapWidth(mapWidth), mapHeight(mapHeight), values(encodedValues)
+{
+	Load(map);
+}
+
+void HeightmapTexture::Load(const std::vector<float>& map)
+{
+	size_t cells = (size_t)mapWidth * mapHeight;
+	texture.id = rlLoadTexture(values.data(), mapWidth, mapHeight, UNCOMPRESSED_R16, 1);
+	texture.width = mapWidth;
+	texture.height = mapHeight;
+	texture.mipmaps = 1; // no mipmaps, they would go stale as tiles are updated
+	texture.format = UNCOMPRESSED_R16;
+	SetTextureFilter(texture, FILTER_BILINEAR);
+	SetTextureWrap(texture, WRAP_CLAMP);
+
+	normals.Calculate(map);
+	normalTexture.id = rlLoadTexture((void*)normals.GetTexels(), mapWidth, mapHeight, UNCOMPRESSED_R8G8B8A8, 1);
+	normalTexture.width = mapWidth;
+	normalTexture.height = mapHeight;
+	normalTexture.mipmaps = 1;
+	normalTexture.format = UNCOMPRESSED_R8G8B8A8;
+	SetTextureFilter(normalTexture, FILTER_BILINEAR);
+	SetTextureWrap(normalTexture, WRAP_CLAMP);
+
+	// room for the whole map, plus the padding that keeps every rectangle 4 bytes aligned. the normal rects of a
+	// rectangle cover at most a cell more on every side, (2 + 2) * DIRTY_TILE_SIZE + 4 cells per tile of the rectangle.
+	// capped for large maps, the rare updates that don't fit (resets) are uploaded synchronously
+	size_t tileCount = (size_t)ErosionMaker::GetDirtyTileCount(mapWidth) * ErosionMaker::GetDirtyTileCount(mapHeight);
+	size_t wholeMapBytes = cells * sizeof(unsigned short) + tileCount * 4;
+	wholeMapBytes += (cells + tileCount * (4 * ErosionMaker::DIRTY_TILE_SIZE + 4)) * NormalMap::TEXEL_BYTES;
+	pixelBufferSize = (int)std::min(wholeMapBytes, (size_t)MAX_PIXEL_BUFFER_BYTES);
+	for (int i = 0; i < PIXEL_BUFFER_COUNT; i++)
+	{
+		pixelBuffers[i] = rlLoadPixelBuffer(pixelBufferSize);
+	}
+}
+
+HeightmapTexture::~HeightmapTexture()
+{
+	for (int i = 0; i < PIXEL_BUFFER_COUNT; i++)
+	{
+		rlUnloadPixelBuffer(pixelBuffers[i]);
+	}
+	UnloadTexture(texture);
+	UnloadTexture(normalTexture);
+}
+
+void HeightmapTexture::Update(const std::vector<float>& map, const std::vector<unsigned int>& tileVersions, unsigned int newVersion)
+{
+	// one rectangle per run of changed tiles in a tile row
+	const int tileSize = ErosionMaker::DIRTY_TILE_SIZE;
+	int tileColumns = ErosionMaker::GetDirtyTileCount(mapWidth);
+	int tileRows = ErosionMaker::GetDirtyTileCount(mapHeight);
+	size_t uploadBytes = 0;
+	rects.clear();
+	for (int tileY = 0; tileY < tileRows; tileY++)
+	{
+		for (int tileX = 0; tileX < tileColumns; tileX++)
+		{
+			if (tileVersions[(size_t)tileY * tileColumns + tileX] <= version)
+				continue;
+			int runEnd = tileX + 1;
+			while (runEnd < tileColumns && tileVersions[(size_t)tileY * tileColumns + runEnd] > version)
+				runEnd++;
+			UploadRect rect;
+			rect.x = tileX * tileSize;
+			rect.y = tileY * tileSize;
+			rect.width = std::min(runEnd * tileSize, mapWidth) - rect.x;
+			rect.height = std::min(rect.y + tileSize, mapHeight) - rect.y;
+			rect.offset = uploadBytes;
+			rects.push_back(rect);
+			uploadBytes += ((size_t)rect.width * rect.height * sizeof(unsigned short) + 3) & ~(size_t)3;
+			tileX = runEnd;
+		}
+	}
+	version = newVersion;
+	if (rects.empty())
+	{
+		lastUploadBytes = 0;
+		return;
+	}
+
+	normalRects.clear();
+	normalOffsets.clear();
+	for (const UploadRect& rect : rects)
+	{
+		NormalRect normalRect;
+		normalRect.x = std::max(rect.x - 1, 0);
+		normalRect.y = std::max(rect.y - 1, 0);
+		normalRect.width = std::min(rect.x + rect.width + 1, mapWidth) - normalRect.x;
+		normalRect.height = std::min(rect.y + rect.height + 1, mapHeight) - normalRect.y;
+		normalRects.push_back(normalRect);
+		normalOffsets.push_back(uploadBytes);
+		uploadBytes += (size_t)normalRect.width * normalRect.height * NormalMap::TEXEL_BYTES;
+	}
+	normals.Calculate(map, normalRects);
+	lastUploadBytes = uploadBytes;
+
+	unsigned int pixelBuffer = pixelBuffers[nextPixelBuffer];
+	bool fits = uploadBytes <= (size_t)pixelBufferSize;
+	unsigned char* data = (pixelBuffer != 0 && fits) ? (unsigned char*)rlMapPixelBuffer(pixelBuffer, (int)uploadBytes) : nullptr;
+	if (data == nullptr)
+	{
+		// no pixel buffers, or more than fits in one: synchronous upload from memory
+		for (const UploadRect& rect : rects)
+		{
+			for (int y = 0; y < rect.height; y++)
+			{
+				ErosionMaker::EncodeHeights(&map[(size_t)(rect.y + y) * mapWidth + rect.x], &values[(size_t)y * rect.width], rect.width);
+			}
+			rlUpdateTexture(texture.id, rect.x, rect.y, rect.width, rect.height, texture.format, values.data());
+		}
+		for (const NormalRect& rect : normalRects)
+		{
+			normalValues.resize((size_t)rect.width * rect.height * NormalMap::TEXEL_BYTES);
+			CopyNormalRows(normals, rect, normalValues.data());
+			rlUpdateTexture(normalTexture.id, rect.x, rect.y, rect.width, rect.height, normalTexture.format, normalValues.data());
+		}
+		return;
+	}
+
+	for (const UploadRect& rect : rects)
+	{
+		unsigned short* rectValues = (unsigned short*)(data + rect.offset);
+		for (int y = 0; y < rect.height; y++)
+		{
+			ErosionMaker::EncodeHeights(&map[(size_t)(rect.y + y) * mapWidth + rect.x], rectValues + (size_t)y * rect.width, rect.width);
+		}
+	}
+	for (size_t i = 0; i < normalRects.size(); i++)
+	{
+		CopyNormalRows(normals, normalRects[i], data + normalOffsets[i]);
+	}
+	rlUnmapPixelBuffer(pixelBuffer);
+	for (const UploadRect& rect : rects)
+	{
+		rlUpdateTextureFromPixelBuffer(texture.id, pixelBuffer, (int)rect.offset, rect.x, rect.y, rect.width, rect.height, texture.format);
+	}
+	for (size_t i = 0; i < normalRects.size(); i++)
+	{
+		const NormalRect& rect = normalRects[i];
+		rlUpdateTextureFromPixelBuffer(normalTexture.id, pixelBuffer, (int)normalOffsets[i], rect.x, rect.y, rect.width, rect.height, normalTexture.format);
+	}
+	nextPixelBuffer = (nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+}
@@ -0,0 +1,66 @@
+#ifndef HEIGHTMAP_TEXTURE
+#define HEIGHTMAP_TEXTURE
+
+#include <cstddef>
+#include <vector>
+#include "raylib.h"
+#include "NormalMap.h"
+
+// heightmap on the GPU as a single channel 16 bit texture: 65536 height levels instead of the 256 of a color channel,
+// and 2 bytes per texel to upload instead of 4.
+// changed tiles are encoded straight into a pixel unpack buffer and the texture is updated from it, so the driver copies
+// them asynchronously. buffers are used in turn, writing the next update never waits for the GPU to read the previous one.
+// the buffers are capped at MAX_PIXEL_BUFFER_BYTES, an update larger than that (a reset of a big map) is uploaded synchronously.
+// the normals of the map go along in an RGBA8 texture: the cells around the changed tiles get new normals in the NormalMap,
+// which also answers the CPU queries, and are uploaded with the heights, so the terrain shader reads a normal per fragment
+// instead of computing it from 8 height taps.
+// owns GPU resources: delete it before closing the window
+class HeightmapTexture
+{
+public:
+	HeightmapTexture(const std::vector<float>& map, int mapWidth, int mapHeight); // uploads the whole map and its normals, tiles are at version 0
+	HeightmapTexture(const std::vector<float>& map, const std::vector<unsigned short>& encodedValues, int mapWidth, int mapHeight); // same with the heights of map already encoded by ErosionMaker::EncodeHeights
+	~HeightmapTexture();
+
+	HeightmapTexture(HeightmapTexture const&) = delete;
+	void operator=(HeightmapTexture const&) = delete;
+
+	// uploads the tiles of map changed since the last update, tileVersions holds the version that last changed each tile
+	// (tiles of ErosionMaker::DIRTY_TILE_SIZE cells, row-major) and newVersion is the newest one
+	void Update(const std::vector<float>& map, const std::vector<unsigned int>& tileVersions, unsigned int newVersion);
+	Texture2D GetTexture() const { return texture; }
+	Texture2D GetNormalTexture() const { return normalTexture; }
+	const NormalMap& GetNormals() const { return normals; } // normals of the map as uploaded, for CPU queries
+	size_t GetLastUploadBytes() const { return lastUploadBytes; }
+
+	static const int PIXEL_BUFFER_COUNT = 3;
+	static const int MAX_PIXEL_BUFFER_BYTES = 64 << 20; // size of a pixel buffer at most, 3 of them. the tiles of a frame usually need far less
+
+private:
+	void Load(const std::vector<float>& map); // creates the textures from values and the normals of map, and the pixel buffers
+
+	typedef struct
+	{
+		int x, y, width, height;
+		size_t offset; // in bytes, in the pixel buffer
+	} UploadRect;
+
+	Texture2D texture;
+	Texture2D normalTexture;
+	NormalMap normals;
+	int mapWidth;
+	int mapHeight;
+	unsigned int version = 0; // newest version uploaded
+	size_t lastUploadBytes = 0;
+
+	unsigned int pixelBuffers[PIXEL_BUFFER_COUNT] = {}; // 0 when pixel buffers aren't supported
+	int pixelBufferSize = 0;
+	int nextPixelBuffer = 0;
+	std::vector<UploadRect> rects;
+	std::vector<NormalRect> normalRects; // rects grown by a cell, a height changes the normals of its neighbors
+	std::vector<size_t> normalOffsets; // of the normal rects, in bytes, in the pixel buffer
+	std::vector<unsigned short> values; // used when the pixel buffer can't be mapped
+	std::vector<unsigned char> normalValues;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "NormalMap.h"
+#include <math.h>
+#include <algorithm>
+#include "raymath.h"
+#include "ThreadPool.h"
+
+// SSE2 is always there on x64, other targets compute one cell at a time
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NORMAL_SSE2
+#endif
+
+static const int NORMAL_ROWS_PER_TASK = 16; // rows of the map computed by a single task of a whole-map pass
+
+// same value as ErosionMaker::CalculateNormal (and the terrain shader before the normal texture)
+static float NormalStrength(int scaleWidth)
+{
+	return 20.0f * scaleWidth / 512.0f;
+}
+
+// Sobel derivatives to a texel, the SSE2 path below does the same operations in the same order
+static void EncodeNormal(float dX, float dY, float strength, unsigned char* texel)
+{
+	float a = dX * strength;
+	float c = dY * strength;
+	float length = sqrtf(a * a + c * c + 1.0f);
+	float inverse = 1.0f / length;
+	float shade = length / sqrtf((a * a + 1.0f) * (c * c + 1.0f));
+	texel[0] = (unsigned char)lrintf(-a * inverse * 127.5f + 127.5f); // rounds to nearest even like _mm_cvtps_epi32
+	texel[1] = (unsigned char)lrintf(inverse * 127.5f + 127.5f);
+	texel[2] = (unsigned char)lrintf(-c * inverse * 127.5f + 127.5f);
+	texel[3] = (unsigned char)lrintf(shade * 255.0f);
+}
+
+void NormalMap::CalculateRow(const float* top, const float* middle, const float* bottom, int mapWidth, int scaleWidth, int first, int last, unsigned char* texels)
+{
+	float strength = NormalStrength(scaleWidth);
+	int x = first;
+	// the first and last columns clamp their neighbors, the SIMD loop only runs on the columns in between
+	for (; x < last && (x == 0 || x == mapWidth - 1); x++)
+	{
+		int left = std::max(x - 1, 0);
+		int right = std::min(x + 1, mapWidth - 1);
+		float dX = top[right] + 2.0f * middle[right] + bottom[right] - top[left] - 2.0f * middle[left] - bottom[left];
+		float dY = bottom[left] + 2.0f * bottom[x] + bottom[right] - top[left] - 2.0f * top[x] - top[right];
+		EncodeNormal(dX, dY, strength, texels + (size_t)x * TEXEL_BYTES);
+	}
+#ifdef NORMAL_SSE2
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(127.5f);
+	const __m128 full = _mm_set1_ps(255.0f);
+	const __m128 scale = _mm_set1_ps(strength);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	int simdLast = std::min(last, mapWidth - 1);
+	for (; x + 4 <= simdLast; x += 4)
+	{
+		__m128 tl = _mm_loadu_ps(top + x - 1);
+		__m128 t = _mm_loadu_ps(top + x);
+		__m128 tr = _mm_loadu_ps(top + x + 1);
+		__m128 l = _mm_loadu_ps(middle + x - 1);
+		__m128 r = _mm_loadu_ps(middle + x + 1);
+		__m128 bl = _mm_loadu_ps(bottom + x - 1);
+		__m128 b = _mm_loadu_ps(bottom + x);
+		__m128 br = _mm_loadu_ps(bottom + x + 1);
+		__m128 dX = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(tr, _mm_mul_ps(two, r)), br), tl), _mm_mul_ps(two, l)), bl);
+		__m128 dY = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(bl, _mm_mul_ps(two, b)), br), tl), _mm_mul_ps(two, t)), tr);
+		__m128 a = _mm_mul_ps(dX, scale);
+		__m128 c = _mm_mul_ps(dY, scale);
+		__m128 aa = _mm_mul_ps(a, a);
+		__m128 cc = _mm_mul_ps(c, c);
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(aa, cc), one));
+		__m128 inverse = _mm_div_ps(one, length);
+		__m128 shade = _mm_div_ps(length, _mm_sqrt_ps(_mm_mul_ps(_mm_add_ps(aa, one), _mm_add_ps(cc, one))));
+		__m128i red = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_xor_ps(a, sign), inverse), half), half));
+		__m128i green = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(inverse, half), half));
+		__m128i blue = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_xor_ps(c, sign), inverse), half), half));
+		__m128i alpha = _mm_cvtps_epi32(_mm_mul_ps(shade, full));
+		// a texel per lane, RGBA in memory order (x86 is little endian)
+		__m128i packed = _mm_or_si128(_mm_or_si128(red, _mm_slli_epi32(green, 8)), _mm_or_si128(_mm_slli_epi32(blue, 16), _mm_slli_epi32(alpha, 24)));
+		_mm_storeu_si128((__m128i*)(texels + (size_t)x * TEXEL_BYTES), packed);
+	}
+#endif
+	for (; x < last; x++)
+	{
+		int left = std::max(x - 1, 0);
+		int right = std::min(x + 1, mapWidth - 1);
+		float dX = top[right] + 2.0f * middle[right] + bottom[right] - top[left] - 2.0f * middle[left] - bottom[left];
+		float dY = bottom[left] + 2.0f * bottom[x] + bottom[right] - top[left] - 2.0f * top[x] - top[right];
+		EncodeNormal(dX, dY, strength, texels + (size_t)x * TEXEL_BYTES);
+	}
+}
+
+NormalMap::NormalMap(int mapWidth, int mapHeight, int scaleWidth) : mapWidth(mapWidth), mapHeight(mapHeight), scaleWidth(scaleWidth > 0 ? scaleWidth : mapWidth)
+{
+	texels.resize((size_t)mapWidth * mapHeight * TEXEL_BYTES);
+}
+
+void NormalMap::CalculateRect(const std::vector<float>& map, const NormalRect& rect)
+{
+	for (int y = rect.y; y < rect.y + rect.height; y++)
+	{
+		const float* middle = map.data() + (size_t)y * mapWidth;
+		const float* top = map.data() + (size_t)std::max(y - 1, 0) * mapWidth;
+		const float* bottom = map.data() + (size_t)std::min(y + 1, mapHeight - 1) * mapWidth;
+		CalculateRow(top, middle, bottom, mapWidth, scaleWidth, rect.x, rect.x + rect.width, texels.data() + (size_t)y * mapWidth * TEXEL_BYTES);
+	}
+}
+
+void NormalMap::Calculate(const std::vector<float>& map, int threads)
+{
+	ThreadPool::GetInstance().ParallelForRows(mapHeight, NORMAL_ROWS_PER_TASK, threads, [&](int firstRow, int lastRow)
+	{
+		CalculateRect(map, { 0, firstRow, mapWidth, lastRow - firstRow });
+	});
+}
+
+void NormalMap::Calculate(const std::vector<float>& map, const std::vector<NormalRect>& rects, int threads)
+{
+	ThreadPool::GetInstance().ParallelFor((int)rects.size(), threads, [&](int index, int worker)
+	{
+		CalculateRect(map, rects[index]);
+	});
+}
+
+Vector3 NormalMap::GetNormal(int x, int y) const
+{
+	x = std::min(std::max(x, 0), mapWidth - 1);
+	y = std::min(std::max(y, 0), mapHeight - 1);
+	const unsigned char* texel = &texels[((size_t)y * mapWidth + x) * TEXEL_BYTES];
+	return Vector3Normalize({ texel[0] / 127.5f - 1.0f, texel[1] / 127.5f - 1.0f, texel[2] / 127.5f - 1.0f });
+}
@@ -0,0 +1,48 @@
+#ifndef NORMAL_MAP
+#define NORMAL_MAP
+
+#include <vector>
+#include "raylib.h"
+
+// cells of a map whose normals are computed together
+typedef struct
+{
+	int x, y, width, height;
+} NormalRect;
+
+// normals of a whole heightmap, computed once with SIMD on the thread pool and kept up to date rect by rect as the map
+// is eroded. the same texels are uploaded as the normal texture of the terrain shader and read for CPU queries (tree
+// placement), so both see the same slopes.
+// a texel is 4 bytes (RGBA8): the unit normal in rgb mapped from (-1, 1) to (0, 255), and in alpha the length the
+// terrain shader used to give the normal (the cross product of its normalized tangents, shorter on slopes, darkens them)
+class NormalMap
+{
+public:
+	static const int TEXEL_BYTES = 4;
+
+	// scaleWidth: the normals are as steep as on an island map of that width (the island spans 32 units whatever its
+	// resolution), 0 = mapWidth. maps that aren't a whole island (terrain chunks) give the width of an island of their cell size
+	NormalMap(int mapWidth, int mapHeight, int scaleWidth = 0);
+
+	void Calculate(const std::vector<float>& map, int threads = 0); // every cell, 0 = all hardware threads
+	void Calculate(const std::vector<float>& map, const std::vector<NormalRect>& rects, int threads = 0); // the cells of the rects, a task per rect
+	// Sobel normal of ErosionMaker::GetNormal at a cell (scaleWidth = mapWidth), clamped to the map, decoded from its texel (8 bits per component)
+	Vector3 GetNormal(int x, int y) const;
+	float GetSlope(int x, int y) const { return 1.0f - GetNormal(x, y).y; } // 0 flat, 1 vertical
+	const unsigned char* GetTexels() const { return texels.data(); } // row-major, TEXEL_BYTES per cell
+	int GetWidth() const { return mapWidth; }
+	int GetHeight() const { return mapHeight; }
+
+	// texels of the cells [first, last) of a row from the rows above, at and below it (the map's own row at the borders)
+	static void CalculateRow(const float* top, const float* middle, const float* bottom, int mapWidth, int scaleWidth, int first, int last, unsigned char* texels);
+
+private:
+	int mapWidth;
+	int mapHeight;
+	int scaleWidth;
+	std::vector<unsigned char> texels;
+
+	void CalculateRect(const std::vector<float>& map, const NormalRect& rect);
+};
+
+#endif
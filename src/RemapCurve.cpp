@@ -0,0 +1,192 @@
+#include "FloatContract.h"
+#include "RemapCurve.h"
+#include <math.h>
+#include <algorithm>
+
+// SSE2 is always there on x64, other targets look up one height at a time
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define REMAP_SSE2
+#endif
+
+const std::vector<Vector2>& RemapCurve::GetDefaultPoints()
+{
+	// describe the remapping of the grayscale heights (beach and craters)
+	static const std::vector<Vector2> defaultPoints =
+	{
+		{0.0f,		0.0f}, // initial point (keep)
+
+		{0.15f,		0.16f}, // flatten beach
+		{0.2f,		0.16f},
+		/*{0.3f,		0.4f}, // add some craters
+		{0.4f,		0.3f},*/
+
+		{1.0f,		1.0f}, // final point (keep)
+	};
+	return defaultPoints;
+}
+
+RemapCurve::RemapCurve()
+{
+	SetPoints(GetDefaultPoints(), RemapInterpolation::PIECEWISE_LINEAR);
+}
+
+RemapCurve::RemapCurve(const std::vector<Vector2>& points, RemapInterpolation interpolation)
+{
+	if (!SetPoints(points, interpolation))
+		SetPoints(GetDefaultPoints(), RemapInterpolation::PIECEWISE_LINEAR);
+}
+
+bool RemapCurve::SetPoints(const std::vector<Vector2>& newPoints, RemapInterpolation newInterpolation)
+{
+	if (newPoints.size() < 2)
+		return false;
+	for (size_t i = 1; i < newPoints.size(); i++)
+	{
+		if (!(newPoints[i].x > newPoints[i - 1].x)) // also rejects NaN
+			return false;
+	}
+	points = newPoints;
+	interpolation = newInterpolation;
+	Compile();
+	return true;
+}
+
+void RemapCurve::Compile()
+{
+	size_t count = points.size();
+	tangents.assign(count, 0.0);
+	if (interpolation == RemapInterpolation::MONOTONE_CUBIC)
+	{
+		// Fritsch-Carlson: secant slopes, averaged at the inner points (0 at local extrema), then limited so every segment
+		// stays monotone
+		std::vector<double> secants(count - 1);
+		for (size_t i = 0; i + 1 < count; i++)
+		{
+			secants[i] = ((double)points[i + 1].y - points[i].y) / ((double)points[i + 1].x - points[i].x);
+		}
+		tangents[0] = secants[0];
+		tangents[count - 1] = secants[count - 2];
+		for (size_t i = 1; i + 1 < count; i++)
+		{
+			tangents[i] = (secants[i - 1] * secants[i] <= 0.0) ? 0.0 : (secants[i - 1] + secants[i]) / 2.0;
+		}
+		for (size_t i = 0; i + 1 < count; i++)
+		{
+			if (secants[i] == 0.0)
+			{
+				tangents[i] = 0.0; // flat segment, stays flat
+				tangents[i + 1] = 0.0;
+				continue;
+			}
+			double alpha = tangents[i] / secants[i];
+			double beta = tangents[i + 1] / secants[i];
+			double length = alpha * alpha + beta * beta;
+			if (length > 9.0)
+			{
+				double tau = 3.0 / sqrt(length);
+				tangents[i] = tau * alpha * secants[i];
+				tangents[i + 1] = tau * beta * secants[i];
+			}
+		}
+	}
+
+	firstHeight = points.front().x;
+	lastHeight = points.back().x;
+	cellsPerHeight = (float)(TABLE_CELLS / ((double)lastHeight - firstHeight));
+	table.resize(2 * (TABLE_CELLS + 1));
+	for (int node = 0; node <= TABLE_CELLS; node++)
+	{
+		table[2 * node] = (float)Interpolate(firstHeight + node / (double)cellsPerHeight);
+	}
+	for (int node = 0; node < TABLE_CELLS; node++)
+	{
+		table[2 * node + 1] = table[2 * node + 2] - table[2 * node];
+	}
+	table[2 * TABLE_CELLS + 1] = 0.0f;
+}
+
+double RemapCurve::Interpolate(double height) const
+{
+	height = std::min(std::max(height, (double)points.front().x), (double)points.back().x);
+	size_t segment = std::upper_bound(points.begin() + 1, points.end() - 1, height, [](double value, const Vector2& point) { return value < point.x; }) - points.begin() - 1;
+	const Vector2& start = points[segment];
+	const Vector2& end = points[segment + 1];
+	double width = (double)end.x - start.x;
+	double t = (height - start.x) / width;
+	if (interpolation == RemapInterpolation::PIECEWISE_LINEAR)
+		return start.y + t * ((double)end.y - start.y);
+
+	// cubic Hermite segment
+	double t2 = t * t;
+	double t3 = t2 * t;
+	return (2.0 * t3 - 3.0 * t2 + 1.0) * start.y + (t3 - 2.0 * t2 + t) * width * tangents[segment]
+		+ (-2.0 * t3 + 3.0 * t2) * end.y + (t3 - t2) * width * tangents[segment + 1];
+}
+
+float RemapCurve::EvaluateExact(float height) const
+{
+	if (!(height >= firstHeight && height <= lastHeight))
+		return height;
+	return (float)Interpolate(height);
+}
+
+float RemapCurve::Evaluate(float height) const
+{
+	if (!(height >= firstHeight && height <= lastHeight)) // NaN is kept too
+		return height;
+	// lastHeight, and rounding just below it, lands on the last node, its difference is 0
+	float cell = std::min((height - firstHeight) * cellsPerHeight, (float)TABLE_CELLS);
+	int node = (int)cell;
+	const float* entry = &table[2 * node];
+	return entry[0] + (cell - (float)node) * entry[1];
+}
+
+void RemapCurve::Apply(float* heights, int count) const
+{
+	int i = 0;
+#ifdef REMAP_SSE2
+	const __m128 first = _mm_set1_ps(firstHeight);
+	const __m128 last = _mm_set1_ps(lastHeight);
+	const __m128 scale = _mm_set1_ps(cellsPerHeight);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxCell = _mm_set1_ps((float)TABLE_CELLS);
+	const float* entries = table.data();
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 height = _mm_loadu_ps(heights + i);
+		__m128 inside = _mm_and_ps(_mm_cmpge_ps(height, first), _mm_cmple_ps(height, last));
+		// the lower clamp only matters to the lanes outside (and NaN, _mm_max_ps returns its second operand), they keep their height
+		__m128 cell = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(height, first), scale), zero), maxCell);
+		__m128i node = _mm_cvttps_epi32(cell);
+		alignas(16) int nodes[4];
+		_mm_store_si128((__m128i*)nodes, node);
+		// no gather in SSE2: a 64 bit load of (height, difference) per lane, then split the pairs
+		__m128 pairs01 = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64*)(entries + 2 * nodes[0])), (const __m64*)(entries + 2 * nodes[1]));
+		__m128 pairs23 = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64*)(entries + 2 * nodes[2])), (const __m64*)(entries + 2 * nodes[3]));
+		__m128 values = _mm_shuffle_ps(pairs01, pairs23, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 differences = _mm_shuffle_ps(pairs01, pairs23, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 remapped = _mm_add_ps(values, _mm_mul_ps(_mm_sub_ps(cell, _mm_cvtepi32_ps(node)), differences));
+		_mm_storeu_ps(heights + i, _mm_or_ps(_mm_and_ps(inside, remapped), _mm_andnot_ps(inside, height)));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		heights[i] = Evaluate(heights[i]);
+	}
+}
+
+float RemapCurve::GetMaxTableError() const
+{
+	float maxError = 0.0f;
+	for (int node = 0; node < TABLE_CELLS; node++)
+	{
+		for (int sample = 1; sample < 4; sample++)
+		{
+			float height = firstHeight + (node + sample / 4.0f) / cellsPerHeight;
+			if (height < lastHeight)
+				maxError = std::max(maxError, fabsf(Evaluate(height) - EvaluateExact(height)));
+		}
+	}
+	return maxError;
+}
@@ -0,0 +1,54 @@
+#ifndef REMAP_CURVE
+#define REMAP_CURVE
+
+#include <vector>
+#include "raylib.h"
+
+// how a remap curve passes through its control points
+enum RemapInterpolation
+{
+	PIECEWISE_LINEAR = 0, // straight segments, sharp kinks at the points
+	MONOTONE_CUBIC = 1, // smooth through the points without overshoot (Fritsch-Carlson), flat segments stay flat
+};
+
+// curve remapping normalized heights (beaches, plateaus, terraces), given by control points (height, remapped height)
+// sorted by height. the curve is compiled once into a table of TABLE_CELLS cells over the heights of its points and
+// evaluated by linear interpolation in the table: the cost of a height doesn't depend on the number of points or the
+// interpolation. heights outside the points are kept as they are
+class RemapCurve
+{
+public:
+	static const int TABLE_CELLS = 4096; // a table of 32 KB, fits in the L1 cache
+
+	RemapCurve(); // the beach curve of the application
+	RemapCurve(const std::vector<Vector2>& points, RemapInterpolation interpolation);
+
+	// replaces the curve and compiles its table, false (curve unchanged) with less than 2 points or heights not strictly increasing
+	bool SetPoints(const std::vector<Vector2>& points, RemapInterpolation interpolation);
+	const std::vector<Vector2>& GetPoints() const { return points; }
+	RemapInterpolation GetInterpolation() const { return interpolation; }
+
+	float Evaluate(float height) const; // remapped height from the table
+	void Apply(float* heights, int count) const; // Evaluate over an array, 4 heights at a time with SSE2, same results bit for bit
+	float EvaluateExact(float height) const; // remapped height from the curve itself, fills the table
+	float GetMaxTableError() const; // largest difference between Evaluate and EvaluateExact, sampled between the table nodes
+
+	static const std::vector<Vector2>& GetDefaultPoints(); // control points of the beach curve
+
+private:
+	std::vector<Vector2> points;
+	std::vector<double> tangents; // slope of the curve at every point (MONOTONE_CUBIC)
+	RemapInterpolation interpolation = RemapInterpolation::PIECEWISE_LINEAR;
+
+	float firstHeight = 0.0f; // heights covered by the table
+	float lastHeight = 1.0f;
+	float cellsPerHeight = 1.0f;
+	// (remapped height at the node, difference to the next node) for the TABLE_CELLS + 1 nodes, interleaved so a lookup is
+	// a single 8 byte load. the difference of the last node is 0
+	std::vector<float> table;
+
+	double Interpolate(double height) const; // the curve between the first and the last point, clamped to them
+	void Compile();
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "TerrainChunks.h"
+#include "raymath.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#define CHUNK_TERRAIN_OFFSET	-1.2f // the island terrain is moved down as much
+#define CHUNK_TERRAIN_HEIGHT	8.0f // world units of a height of 1, terrain shader
+
+TerrainChunks::TerrainChunks(const ChunkSettings& settings, Material terrainMaterial)
+	: streamer(settings), terrainMaterial(terrainMaterial)
+{
+	// a vertex every other cell, as on the island
+	float size = streamer.GetChunkSize();
+	int resolution = std::max(settings.chunkCells / 2, 1);
+	mesh = GenMeshPlane(size, size, resolution, resolution);
+}
+
+TerrainChunks::~TerrainChunks()
+{
+	for (std::map<long long, std::unique_ptr<GpuChunk>>::iterator chunk = chunks.begin(); chunk != chunks.end(); chunk++)
+	{
+		Unload(chunk->second.get());
+	}
+	UnloadMesh(mesh); // the material belongs to the island terrain
+}
+
+void TerrainChunks::Upload(const TerrainChunk& chunk)
+{
+	int side = streamer.GetSettings().chunkCells + 1;
+	std::unique_ptr<GpuChunk> gpuChunk(new GpuChunk());
+	gpuChunk->coord = chunk.coord;
+
+	gpuChunk->texture.id = rlLoadTexture((void*)chunk.heights.data(), side, side, UNCOMPRESSED_R16, 1);
+	gpuChunk->texture.width = side;
+	gpuChunk->texture.height = side;
+	gpuChunk->texture.mipmaps = 1;
+	gpuChunk->texture.format = UNCOMPRESSED_R16;
+	SetTextureFilter(gpuChunk->texture, FILTER_BILINEAR);
+	SetTextureWrap(gpuChunk->texture, WRAP_CLAMP);
+
+	gpuChunk->normalTexture.id = rlLoadTexture((void*)chunk.normals.data(), side, side, UNCOMPRESSED_R8G8B8A8, 1);
+	gpuChunk->normalTexture.width = side;
+	gpuChunk->normalTexture.height = side;
+	gpuChunk->normalTexture.mipmaps = 1;
+	gpuChunk->normalTexture.format = UNCOMPRESSED_R8G8B8A8;
+	SetTextureFilter(gpuChunk->normalTexture, FILTER_BILINEAR);
+	SetTextureWrap(gpuChunk->normalTexture, WRAP_CLAMP);
+
+	// a material of its own, the island material's maps are shared with the island
+	memcpy(gpuChunk->maps, terrainMaterial.maps, sizeof(gpuChunk->maps));
+	gpuChunk->maps[1].texture = gpuChunk->normalTexture; // uniform texture1
+	gpuChunk->maps[2].texture = gpuChunk->texture; // uniform texture2
+	gpuChunk->material = terrainMaterial;
+	gpuChunk->material.maps = gpuChunk->maps;
+
+	Vector3 center = streamer.GetChunkCenter(chunk.coord);
+	gpuChunk->transform = MatrixTranslate(center.x, CHUNK_TERRAIN_OFFSET, center.z);
+	chunks[Key(chunk.coord)] = std::move(gpuChunk);
+}
+
+void TerrainChunks::Unload(GpuChunk* gpuChunk)
+{
+	UnloadTexture(gpuChunk->texture);
+	UnloadTexture(gpuChunk->normalTexture);
+}
+
+void TerrainChunks::Update(Camera camera)
+{
+	streamer.SetView(camera.position, Vector3Subtract(camera.target, camera.position));
+
+	// the wanted chunks by priority, a few uploads per frame keep the frame time even
+	int uploads = 0;
+	const std::vector<ChunkCoord>& wanted = streamer.GetWantedChunks();
+	for (size_t i = 0; i < wanted.size() && uploads < UPLOADS_PER_FRAME; i++)
+	{
+		if (chunks.find(Key(wanted[i])) != chunks.end())
+			continue;
+		std::shared_ptr<const TerrainChunk> chunk = streamer.GetChunk(wanted[i]);
+		if (!chunk)
+			continue;
+		Upload(*chunk);
+		uploads++;
+	}
+
+	// a chunk past the view distance by more than its size is unloaded, closer ones stay so turning around doesn't reload them
+	float keepDistance = streamer.GetSettings().viewDistance + streamer.GetChunkSize();
+	for (std::map<long long, std::unique_ptr<GpuChunk>>::iterator chunk = chunks.begin(); chunk != chunks.end();)
+	{
+		Vector3 center = streamer.GetChunkCenter(chunk->second->coord);
+		float dx = center.x - camera.position.x;
+		float dz = center.z - camera.position.z;
+		if (sqrtf(dx * dx + dz * dz) > keepDistance)
+		{
+			Unload(chunk->second.get());
+			chunk = chunks.erase(chunk);
+		}
+		else
+		{
+			chunk++;
+		}
+	}
+}
+
+void TerrainChunks::AppendModels(std::vector<Model>* models, Camera camera)
+{
+	// chunks entirely behind the camera plane are skipped, the bounding sphere covers the heights
+	Vector3 forward = Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+	float size = streamer.GetChunkSize();
+	float radius = sqrtf(2.0f * size * size + CHUNK_TERRAIN_HEIGHT * CHUNK_TERRAIN_HEIGHT) / 2.0f;
+	for (std::map<long long, std::unique_ptr<GpuChunk>>::iterator chunk = chunks.begin(); chunk != chunks.end(); chunk++)
+	{
+		Vector3 center = streamer.GetChunkCenter(chunk->second->coord);
+		center.y = CHUNK_TERRAIN_OFFSET + CHUNK_TERRAIN_HEIGHT / 2.0f;
+		if (Vector3DotProduct(Vector3Subtract(center, camera.position), forward) < -radius)
+			continue;
+		Model model = { 0 };
+		model.transform = chunk->second->transform;
+		model.meshCount = 1;
+		model.meshes = &mesh;
+		model.materialCount = 1;
+		model.materials = &chunk->second->material;
+		model.meshMaterial = &meshMaterial;
+		models->push_back(model);
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef TERRAIN_CHUNKS
+#define TERRAIN_CHUNKS
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "raylib.h"
+#include "rlgl.h"
+#include "ChunkStreamer.h"
+
+// streamed terrain on the GPU: the chunks of a ChunkStreamer around the camera, each a heightmap and a normal texture
+// drawn on a shared plane mesh with the terrain shader. Update uploads a few finished chunks per frame, those in the
+// view direction first, and unloads the ones left behind; the streamer generates on its own threads, so a frame never
+// waits for a chunk, missing ones are simply not drawn yet.
+// owns GPU resources: delete it before closing the window
+class TerrainChunks
+{
+public:
+	// terrainMaterial: shader and maps of the island terrain, the chunks replace the normal and height textures
+	TerrainChunks(const ChunkSettings& settings, Material terrainMaterial);
+	~TerrainChunks();
+
+	TerrainChunks(TerrainChunks const&) = delete;
+	void operator=(TerrainChunks const&) = delete;
+
+	void Update(Camera camera); // streams around the camera, uploads at most UPLOADS_PER_FRAME chunks
+	// models of the uploaded chunks not behind the camera, valid until the next Update
+	void AppendModels(std::vector<Model>* models, Camera camera);
+	ChunkStreamerStatistics GetStatistics() { return streamer.GetStatistics(); }
+	int GetUploadedCount() const { return (int)chunks.size(); }
+
+	static const int UPLOADS_PER_FRAME = 2;
+
+private:
+	typedef struct
+	{
+		ChunkCoord coord;
+		Texture2D texture; // 16 bit heights
+		Texture2D normalTexture;
+		Material material; // terrain material with the textures of the chunk
+		MaterialMap maps[MAX_MATERIAL_MAPS];
+		Matrix transform;
+	} GpuChunk;
+
+	static long long Key(ChunkCoord coord) { return ((long long)coord.x << 32) | (unsigned int)coord.z; }
+	void Upload(const TerrainChunk& chunk);
+	void Unload(GpuChunk* gpuChunk);
+
+	ChunkStreamer streamer;
+	Material terrainMaterial;
+	Mesh mesh;
+	int meshMaterial = 0;
+	std::map<long long, std::unique_ptr<GpuChunk>> chunks;
+};
+
+#endif
@@ -0,0 +1,783 @@
+#include "ErosionBatch.h"
+#include "ErosionBenchmark.h"
+#include "ErosionMaker.h"
+#include "ErosionVerification.h"
+#include "ThreadPool.h"
+#include "TreeBillboards.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <climits>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+
+// the generator only needs the image writer of raylib's single header libraries, no window or GL context
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "external/stb_image_write.h"
+
+#define MAP_DEFAULT_SIZE		512 // width and height of heightmap when not given on the command line
+#define MAP_MAX_SIZE			16384 // largest width or height accepted
+#define DEFAULT_DROPLETS		1000000 // droplets when not given on the command line
+#define DEFAULT_PIPE_ITERATIONS	1000 // time steps of the virtual pipe model when not given on the command line
+#define ERODE_BATCH_DROPLETS	(1 << 20) // droplets per Erode call, bounds the spawn arrays and paces the progress output
+#define STATISTICS_ROWS			12 // rows of the droplet lifetime histogram
+#define BATCH_LINE_LENGTH		4096 // longest line of a batch file
+#define BATCH_MAX_TOKENS		128 // options and values on a line of a batch file
+#define BENCHMARK_MAP_SIZE		4096 // width and height of heightmap of --layout-benchmark when not given
+#define BENCHMARK_DROPLETS		200000 // droplets eroded with each layout by --layout-benchmark
+
+// headless terrain generator: noise -> Gradient -> Remap -> Erode, written to disk.
+// same pipeline as the interactive application without a window, so it runs on machines without a GPU
+
+// settings read from the command line
+typedef struct
+{
+	unsigned int seed = 0; // droplet sequence and noise seed, seed 0 gives the noise of the interactive application
+	NoiseParameters noise; // base heights, its seed is replaced by seed
+	int mapWidth = MAP_DEFAULT_SIZE;
+	int mapHeight = MAP_DEFAULT_SIZE;
+	bool mapSizeGiven = false; // --map-size was on the command line, the layout benchmark defaults to a larger map
+	GradientType gradient = GradientType::SQUARE;
+	long long droplets = DEFAULT_DROPLETS; // pipe iterations with the PIPES model
+	bool dropletsGiven = false; // --droplets was on the command line, otherwise the default of the model
+	int multiresolutionLevels = 0; // 0 = flat erosion, otherwise levels of ErodeMultiresolution
+	int thermalIterations = 0; // ErodeThermal after the erosion, crumbles the slopes steeper than the talus angle
+	std::vector<Vector2> remapPoints; // control points of the remap curve, none = the beach curve of the interactive application
+	RemapInterpolation remapInterpolation = RemapInterpolation::PIECEWISE_LINEAR;
+	const char* outputPath = "terrain.pgm";
+	bool quiet = false;
+	bool statistics = false; // prints what the droplets did after the erosion
+	bool verify = false; // runs ErosionVerification instead of generating a terrain
+	bool printGoldenHashes = false;
+	bool benchmark = false; // runs ErosionBenchmark instead of generating a terrain
+	bool layoutBenchmark = false;
+	const char* batchPath = nullptr; // job list of the batch mode, nullptr = a single terrain
+	long long memoryLimit = 2048; // MB, peak memory estimated for the maps of a batch eroded at once
+	int intraMapSize = 1024; // maps of a batch with at least this many cells squared use every thread on their own
+} GeneratorSettings;
+
+// erosion parameter that can be set with --name value
+typedef struct
+{
+	const char* name;
+	float* floatValue; // exactly one of the two is set
+	int* intValue;
+} ErosionParameter;
+
+static void PrintUsage(const char* program)
+{
+	printf("usage: %s [options]\n", program);
+	printf("  --output FILE             .pgm (16 bit), .png (8 bit), .r16 (raw 16 bit) or .r32 (raw float), default terrain.pgm\n");
+	printf("  --seed N                  droplet and noise seed, default 0\n");
+	printf("  --map-size SIZE | WxH     3 to %i cells per side, default %i\n", MAP_MAX_SIZE, MAP_DEFAULT_SIZE);
+	printf("  --noise fbm|ridged|warped base heights: fBm, ridged multifractal or domain warped fBm, default fbm\n");
+	printf("  --octaves N               octaves of the noise, 1 to 16, default 6\n");
+	printf("  --gradient TYPE           square, circle, diamond or star, default square\n");
+	printf("  --model droplets|pipes    erosion model: particles or the virtual pipe water grid, default droplets\n");
+	printf("  --droplets N              droplets on the full map, default %i, or pipe iterations, default %i\n", DEFAULT_DROPLETS, DEFAULT_PIPE_ITERATIONS);
+	printf("  --multiresolution LEVELS  erode coarse to fine over up to LEVELS halved maps (droplets only)\n");
+	printf("  --thermal N               thermal erosion iterations after the erosion, default 0\n");
+	printf("  --remap X:Y,X:Y,...       remap curve of the shaped heights, at least 2 points by increasing X, default the beach curve\n");
+	printf("  --remap-interpolation linear|cubic\n");
+	printf("                            segments of the remap curve, cubic is smooth and monotone, default linear\n");
+	printf("  --threads N               0 = all hardware threads (default), doesn't change the result\n");
+	printf("  --kernel scalar|packet    droplet kernel, default scalar\n");
+	printf("  --layout row|tiled        storage of the scalar kernel, default row\n");
+	printf("  --radius N --lifetime N --inertia X --capacity X --min-capacity X --erode-speed X\n");
+	printf("  --deposit-speed X --evaporate-speed X --gravity X --water X --speed X\n");
+	printf("                            droplet parameters, defaults of ErosionMaker\n");
+	printf("  --talus-angle X --thermal-rate X\n");
+	printf("                            thermal erosion parameters, defaults of ErosionMaker\n");
+	printf("  --quiet                   only print errors\n");
+	printf("  --stats                   prints droplet statistics: lifetimes, how droplets ended, steps and material moved\n");
+	printf("  --verify                  checks the droplet kernels against the golden outputs and the reference kernel, exit code 3 on failure\n");
+	printf("  --print-golden            prints the verification cases with the hashes of this build\n");
+	printf("  --benchmark               runs the microbenchmarks of the erosion maker and tree placement, JSON on stdout, summary on stderr\n");
+	printf("  --layout-benchmark        compares the row-major and tiled layouts on the --map-size map, default %ix%i\n", BENCHMARK_MAP_SIZE, BENCHMARK_MAP_SIZE);
+	printf("  --batch FILE              generates the maps listed in FILE, a map per line given by options of this list\n");
+	printf("                            (--seed --gradient --map-size --output ...) that override the command line ones, # comments\n");
+	printf("  --memory-limit MB         batch: memory of the maps eroded at once, 0 = unlimited, default 2048\n");
+	printf("  --intra-map-size N        batch: maps with at least NxN cells run one at a time on every thread, smaller ones\n");
+	printf("                            run a map per thread, default 1024\n");
+}
+
+// reads value as a whole number in [min, max]
+static bool ParseInt(const char* value, long long min, long long max, long long* result)
+{
+	char* end;
+	long long parsed = strtoll(value, &end, 10);
+	if (end == value || *end != '\0' || parsed < min || parsed > max)
+		return false;
+	*result = parsed;
+	return true;
+}
+
+static bool ParseArguments(int argc, char** argv, GeneratorSettings* settings, ErosionParameters* erosionParameters)
+{
+	const ErosionParameter parameters[] =
+	{
+		{ "--radius", nullptr, &erosionParameters->erosionRadius },
+		{ "--lifetime", nullptr, &erosionParameters->maxDropletLifetime },
+		{ "--inertia", &erosionParameters->inertia, nullptr },
+		{ "--capacity", &erosionParameters->sedimentCapacityFactor, nullptr },
+		{ "--min-capacity", &erosionParameters->minSedimentCapacity, nullptr },
+		{ "--erode-speed", &erosionParameters->erodeSpeed, nullptr },
+		{ "--deposit-speed", &erosionParameters->depositSpeed, nullptr },
+		{ "--evaporate-speed", &erosionParameters->evaporateSpeed, nullptr },
+		{ "--gravity", &erosionParameters->gravity, nullptr },
+		{ "--water", &erosionParameters->initialWaterVolume, nullptr },
+		{ "--speed", &erosionParameters->initialSpeed, nullptr },
+		{ "--talus-angle", &erosionParameters->thermalTalusAngle, nullptr },
+		{ "--thermal-rate", &erosionParameters->thermalRate, nullptr },
+	};
+	const char* gradients[] = { "square", "circle", "diamond", "star" }; // in GradientType order
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		if (strcmp(option, "--quiet") == 0)
+		{
+			settings->quiet = true;
+			continue;
+		}
+		if (strcmp(option, "--stats") == 0)
+		{
+			settings->statistics = true;
+			continue;
+		}
+		if (strcmp(option, "--verify") == 0)
+		{
+			settings->verify = true;
+			continue;
+		}
+		if (strcmp(option, "--print-golden") == 0)
+		{
+			settings->printGoldenHashes = true;
+			continue;
+		}
+		if (strcmp(option, "--benchmark") == 0)
+		{
+			settings->benchmark = true;
+			continue;
+		}
+		if (strcmp(option, "--layout-benchmark") == 0)
+		{
+			settings->layoutBenchmark = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+			return false; // every other option takes a value
+		const char* value = argv[++i];
+		long long number;
+
+		if (strcmp(option, "--output") == 0)
+		{
+			settings->outputPath = value;
+		}
+		else if (strcmp(option, "--seed") == 0)
+		{
+			if (!ParseInt(value, 0, 0xFFFFFFFFll, &number))
+				return false;
+			settings->seed = (unsigned int)number;
+		}
+		else if (strcmp(option, "--map-size") == 0)
+		{
+			int width, height;
+			char separator, rest;
+			int fields = sscanf(value, "%d%c%d%c", &width, &separator, &height, &rest);
+			if (fields == 1)
+				height = width;
+			else if (fields != 3 || (separator != 'x' && separator != 'X'))
+				return false;
+			if (width < 3 || height < 3 || width > MAP_MAX_SIZE || height > MAP_MAX_SIZE)
+				return false;
+			settings->mapWidth = width;
+			settings->mapHeight = height;
+			settings->mapSizeGiven = true;
+		}
+		else if (strcmp(option, "--noise") == 0)
+		{
+			if (strcmp(value, "fbm") == 0)
+				settings->noise.type = NoiseType::FBM;
+			else if (strcmp(value, "ridged") == 0)
+				settings->noise.type = NoiseType::RIDGED;
+			else if (strcmp(value, "warped") == 0)
+				settings->noise.type = NoiseType::DOMAIN_WARPED;
+			else
+				return false;
+		}
+		else if (strcmp(option, "--octaves") == 0)
+		{
+			if (!ParseInt(value, 1, 16, &number))
+				return false;
+			settings->noise.octaves = (int)number;
+		}
+		else if (strcmp(option, "--gradient") == 0)
+		{
+			int type = 0;
+			while (type < 4 && strcmp(value, gradients[type]) != 0)
+				type++;
+			if (type == 4)
+				return false;
+			settings->gradient = (GradientType)type;
+		}
+		else if (strcmp(option, "--droplets") == 0)
+		{
+			if (!ParseInt(value, 0, 1ll << 40, &settings->droplets))
+				return false;
+			settings->dropletsGiven = true;
+		}
+		else if (strcmp(option, "--multiresolution") == 0)
+		{
+			if (!ParseInt(value, 1, 8, &number))
+				return false;
+			settings->multiresolutionLevels = (int)number;
+		}
+		else if (strcmp(option, "--thermal") == 0)
+		{
+			if (!ParseInt(value, 0, 1000000, &number))
+				return false;
+			settings->thermalIterations = (int)number;
+		}
+		else if (strcmp(option, "--remap") == 0)
+		{
+			settings->remapPoints.clear();
+			const char* point = value;
+			while (true)
+			{
+				float x, y;
+				int length;
+				if (sscanf(point, "%f:%f%n", &x, &y, &length) != 2)
+					return false;
+				settings->remapPoints.push_back({ x, y });
+				point += length;
+				if (*point == '\0')
+					break;
+				if (*point++ != ',')
+					return false;
+			}
+		}
+		else if (strcmp(option, "--remap-interpolation") == 0)
+		{
+			if (strcmp(value, "linear") == 0)
+				settings->remapInterpolation = RemapInterpolation::PIECEWISE_LINEAR;
+			else if (strcmp(value, "cubic") == 0)
+				settings->remapInterpolation = RemapInterpolation::MONOTONE_CUBIC;
+			else
+				return false;
+		}
+		else if (strcmp(option, "--batch") == 0)
+		{
+			settings->batchPath = value;
+		}
+		else if (strcmp(option, "--memory-limit") == 0)
+		{
+			if (!ParseInt(value, 0, 1ll << 30, &settings->memoryLimit))
+				return false;
+		}
+		else if (strcmp(option, "--intra-map-size") == 0)
+		{
+			if (!ParseInt(value, 3, MAP_MAX_SIZE + 1, &number))
+				return false;
+			settings->intraMapSize = (int)number;
+		}
+		else if (strcmp(option, "--threads") == 0)
+		{
+			if (!ParseInt(value, 0, 1024, &number))
+				return false;
+			erosionParameters->threadCount = (int)number;
+		}
+		else if (strcmp(option, "--model") == 0)
+		{
+			if (strcmp(value, "droplets") == 0)
+				erosionParameters->model = ErosionModel::DROPLETS;
+			else if (strcmp(value, "pipes") == 0)
+				erosionParameters->model = ErosionModel::PIPES;
+			else
+				return false;
+		}
+		else if (strcmp(option, "--kernel") == 0)
+		{
+			if (strcmp(value, "scalar") == 0)
+				erosionParameters->kernel = ErosionKernel::SCALAR;
+			else if (strcmp(value, "packet") == 0)
+				erosionParameters->kernel = ErosionKernel::PACKET;
+			else
+				return false;
+		}
+		else if (strcmp(option, "--layout") == 0)
+		{
+			if (strcmp(value, "row") == 0)
+				erosionParameters->layout = HeightmapLayout::ROW_MAJOR;
+			else if (strcmp(value, "tiled") == 0)
+				erosionParameters->layout = HeightmapLayout::TILED;
+			else
+				return false;
+		}
+		else
+		{
+			const ErosionParameter* parameter = nullptr;
+			for (const ErosionParameter& candidate : parameters)
+			{
+				if (strcmp(option, candidate.name) == 0)
+					parameter = &candidate;
+			}
+			if (parameter == nullptr)
+				return false;
+			char* end;
+			double parsed = strtod(value, &end);
+			if (end == value || *end != '\0' || !(parsed >= 0.0)) // every parameter is positive, rejects NaN
+				return false;
+			if (parameter->intValue != nullptr)
+				*parameter->intValue = (int)parsed;
+			else
+				*parameter->floatValue = (float)parsed;
+		}
+	}
+	if (erosionParameters->erosionRadius < 1 || erosionParameters->maxDropletLifetime < 1)
+		return false;
+	if (erosionParameters->model == ErosionModel::PIPES && settings->multiresolutionLevels > 0)
+		return false; // the pyramid only runs droplets
+	if (!settings->dropletsGiven)
+		settings->droplets = (erosionParameters->model == ErosionModel::PIPES) ? DEFAULT_PIPE_ITERATIONS : DEFAULT_DROPLETS;
+	RemapCurve curve;
+	if (!settings->remapPoints.empty() && !curve.SetPoints(settings->remapPoints, settings->remapInterpolation))
+		return false;
+	return true;
+}
+
+static bool EndsWith(const char* text, const char* suffix)
+{
+	size_t textLength = strlen(text);
+	size_t suffixLength = strlen(suffix);
+	return textLength >= suffixLength && strcmp(text + textLength - suffixLength, suffix) == 0;
+}
+
+// writes the map in the format given by the extension of path
+static bool WriteHeightmap(const char* path, const std::vector<float>& map, int mapWidth, int mapHeight)
+{
+	if (EndsWith(path, ".png"))
+	{
+		std::vector<unsigned char> pixels(map.size());
+		for (size_t i = 0; i < map.size(); i++)
+		{
+			pixels[i] = (unsigned char)(std::min(1.0f, std::max(0.0f, map[i])) * 255.0f + 0.5f);
+		}
+		return stbi_write_png(path, mapWidth, mapHeight, 1, pixels.data(), mapWidth) != 0;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr)
+		return false;
+	bool written;
+	if (EndsWith(path, ".r32"))
+	{
+		written = fwrite(map.data(), sizeof(float), map.size(), file) == map.size(); // native (little endian) floats
+	}
+	else if (EndsWith(path, ".r16"))
+	{
+		std::vector<unsigned short> values(map.size());
+		ErosionMaker::EncodeHeights(map.data(), values.data(), (int)values.size()); // the 16 bit values of the heightmap texture
+		written = fwrite(values.data(), sizeof(unsigned short), values.size(), file) == values.size(); // little endian
+	}
+	else
+	{
+		// binary PGM, 16 bit samples are big endian
+		std::vector<unsigned short> values(map.size());
+		ErosionMaker::EncodeHeights(map.data(), values.data(), (int)values.size());
+		std::vector<unsigned char> bytes(values.size() * 2);
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			bytes[2 * i] = (unsigned char)(values[i] >> 8);
+			bytes[2 * i + 1] = (unsigned char)(values[i] & 0xFF);
+		}
+		written = fprintf(file, "P5\n%d %d\n65535\n", mapWidth, mapHeight) > 0;
+		written = written && fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	}
+	return (fclose(file) == 0) && written;
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count() / 1000000000.0;
+}
+
+static void PrintDropletStatistics(const DropletStatistics& statistics)
+{
+#if EROSION_STATISTICS
+	if (statistics.droplets == 0)
+		return;
+	double droplets = (double)statistics.droplets;
+	long long steps = statistics.erodeSteps + statistics.depositSteps;
+	printf("droplets %lld, %.2f steps each (%.2f eroding, %.2f depositing)\n", statistics.droplets, steps / droplets, statistics.erodeSteps / droplets, statistics.depositSteps / droplets);
+	printf("  ended  %.2f%% at the edge, %.2f%% stalled, %.2f%% at max lifetime\n",
+		statistics.ends[DropletEnd::EDGE] * 100.0 / droplets, statistics.ends[DropletEnd::STALLED] * 100.0 / droplets, statistics.ends[DropletEnd::LIFETIME] * 100.0 / droplets);
+	printf("  speed  %lld resets of a NaN speed (%.3f per step)\n", statistics.nanSpeeds, steps > 0 ? (double)statistics.nanSpeeds / steps : 0.0);
+	printf("  moved  %.6g eroded, %.6g deposited, %.6g carried away by dying droplets\n", statistics.eroded, statistics.deposited, statistics.eroded - statistics.deposited);
+
+	// lifetimes in STATISTICS_ROWS rows of equal step ranges
+	int lifetimes = (int)statistics.lifetimes.size();
+	int rowSteps = std::max((lifetimes + STATISTICS_ROWS - 1) / STATISTICS_ROWS, 1);
+	for (int first = 0; first < lifetimes; first += rowSteps)
+	{
+		int last = std::min(first + rowSteps, lifetimes) - 1;
+		long long count = 0;
+		for (int steps = first; steps <= last; steps++)
+			count += statistics.lifetimes[steps];
+		double percent = count * 100.0 / droplets;
+		printf("  %4d-%-4d steps %7.2f%% %.*s\n", first, last, percent, (int)(percent / 2.0 + 0.5), "##################################################");
+	}
+#else
+	printf("droplet statistics were compiled out (EROSION_STATISTICS is 0)\n");
+#endif
+}
+
+// reads the maps of the batch file, every line starts from the command line settings and parameters
+static bool LoadBatch(const GeneratorSettings& base, const ErosionParameters& baseParameters, std::vector<MapJob>* jobs)
+{
+	FILE* file = fopen(base.batchPath, "r");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "could not read %s\n", base.batchPath);
+		return false;
+	}
+	std::set<std::string> outputs;
+	char line[BATCH_LINE_LENGTH];
+	int lineNumber = 0;
+	bool valid = true;
+	while (valid && fgets(line, sizeof(line), file) != nullptr)
+	{
+		lineNumber++;
+		char* comment = strchr(line, '#');
+		if (comment != nullptr)
+			*comment = '\0';
+		char* tokens[BATCH_MAX_TOKENS + 1];
+		char program[] = "batch"; // ParseArguments skips the program name
+		tokens[0] = program;
+		int count = 1;
+		for (char* token = strtok(line, " \t\r\n"); token != nullptr && valid; token = strtok(nullptr, " \t\r\n"))
+		{
+			valid = count <= BATCH_MAX_TOKENS;
+			tokens[count++] = token;
+		}
+		if (count == 1)
+			continue; // blank or comment
+
+		GeneratorSettings settings = base;
+		ErosionParameters parameters = baseParameters;
+		settings.batchPath = nullptr;
+		valid = valid && ParseArguments(count, tokens, &settings, &parameters) && settings.batchPath == nullptr && !settings.verify && !settings.printGoldenHashes;
+		if (!valid)
+		{
+			fprintf(stderr, "%s:%i: invalid map options\n", base.batchPath, lineNumber);
+			break;
+		}
+		if (!outputs.insert(settings.outputPath).second)
+		{
+			fprintf(stderr, "%s:%i: %s is already the output of another map\n", base.batchPath, lineNumber, settings.outputPath);
+			valid = false;
+			break;
+		}
+
+		MapJob job;
+		job.seed = settings.seed;
+		job.noise = settings.noise;
+		job.noise.seed = settings.seed;
+		job.mapWidth = settings.mapWidth;
+		job.mapHeight = settings.mapHeight;
+		job.gradient = settings.gradient;
+		job.droplets = settings.droplets;
+		job.multiresolutionLevels = settings.multiresolutionLevels;
+		job.thermalIterations = settings.thermalIterations;
+		job.parameters = parameters;
+		job.parameters.pipeCellLength = 4.0f / settings.mapWidth; // same scale as the interactive application
+		job.parameters.thermalCellLength = 4.0f / settings.mapWidth;
+		job.outputPath = settings.outputPath;
+		if (!settings.remapPoints.empty())
+			job.remapCurve = std::make_shared<RemapCurve>(settings.remapPoints, settings.remapInterpolation);
+		jobs->push_back(job);
+	}
+	fclose(file);
+	return valid;
+}
+
+// generates every map of the batch file and reports the throughput of the whole batch
+static int RunBatch(const GeneratorSettings& settings, const ErosionParameters& parameters)
+{
+	std::vector<MapJob> jobs;
+	if (!LoadBatch(settings, parameters, &jobs))
+		return 1;
+
+	ErosionBatch batch;
+	batch.threadCount = parameters.threadCount;
+	batch.memoryBudget = (size_t)settings.memoryLimit << 20;
+	batch.intraMapCells = (long long)settings.intraMapSize * settings.intraMapSize;
+	batch.writeMap = [](const MapJob& job, const std::vector<float>& map)
+	{
+		return WriteHeightmap(job.outputPath.c_str(), map, job.mapWidth, job.mapHeight);
+	};
+	int finished = 0;
+	batch.jobFinished = [&](int jobIndex, const MapJobResult& result)
+	{
+		const MapJob& job = jobs[jobIndex];
+		finished++;
+		if (!result.written)
+			fprintf(stderr, "could not write %s\n", job.outputPath.c_str());
+		else if (!settings.quiet)
+			printf("%4i/%-4i %s: %ix%i, seed %u, %lld %s, %.3f s%s\n", finished, (int)jobs.size(), job.outputPath.c_str(), job.mapWidth, job.mapHeight,
+				job.seed, result.droplets, job.parameters.model == ErosionModel::PIPES ? "pipe iterations" : "droplets", result.seconds, result.intraMap ? " (every thread)" : "");
+	};
+
+	int threads = parameters.threadCount > 0 ? parameters.threadCount : ThreadPool::GetHardwareThreadCount();
+	if (!settings.quiet)
+	{
+		printf("batch: %i maps, %i threads, memory limit %lld MB\n", (int)jobs.size(), threads, settings.memoryLimit);
+		for (const MapJob& job : jobs)
+		{
+			size_t bytes = ErosionBatch::EstimateJobBytes(job);
+			if (batch.memoryBudget > 0 && bytes > batch.memoryBudget)
+				printf("  %s needs about %.0f MB, more than the limit: it runs alone\n", job.outputPath.c_str(), bytes / 1048576.0);
+		}
+	}
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<MapJobResult> results = batch.Run(jobs);
+	double seconds = SecondsSince(begin);
+
+	int written = 0;
+	long long droplets = 0;
+	for (const MapJobResult& result : results)
+	{
+		written += result.written ? 1 : 0;
+		droplets += result.droplets;
+	}
+	if (!settings.quiet)
+	{
+		printf("%i of %i maps in %.3f s: %.1f maps/hour, %.0f droplets/s, peak memory estimate %.1f MB\n", written, (int)jobs.size(), seconds,
+			seconds > 0.0 ? written * 3600.0 / seconds : 0.0, seconds > 0.0 ? droplets / seconds : 0.0, batch.GetPeakReservedBytes() / 1048576.0);
+	}
+	return (written == (int)jobs.size()) ? 0 : 2;
+}
+
+// distinct cache lines (64 bytes) and pages (4 KB) holding the cells a droplet step reads and writes around the node
+template <class Layout>
+static void CountStepFootprint(const Layout& cells, int nodeX, int nodeY, int radius, std::vector<size_t>* lines, std::vector<size_t>* pages)
+{
+	lines->clear();
+	pages->clear();
+	for (int y = -radius; y <= radius + 1; y++) // brush plus the next row and column of the cell nodes
+	{
+		for (int x = -radius; x <= radius + 1; x++)
+		{
+			size_t byteOffset = cells.Index(nodeX + x, nodeY + y) * sizeof(float);
+			lines->push_back(byteOffset / 64);
+			pages->push_back(byteOffset / 4096);
+		}
+	}
+	std::sort(lines->begin(), lines->end());
+	lines->erase(std::unique(lines->begin(), lines->end()), lines->end());
+	std::sort(pages->begin(), pages->end());
+	pages->erase(std::unique(pages->begin(), pages->end()), pages->end());
+}
+
+// compares the row-major and tiled layouts of the droplet kernel on a map of the given size and prints the results
+static void RunLayoutBenchmark(int mapWidth, int mapHeight)
+{
+	ErosionMaker* erosionMaker = &ErosionMaker::GetInstance();
+	erosionMaker->parameters.kernel = ErosionKernel::SCALAR; // the layout only applies to the scalar kernel
+	printf("layout benchmark: %ix%i map, %i droplets per layout, erosion radius %i\n", mapWidth, mapHeight, BENCHMARK_DROPLETS, erosionMaker->parameters.erosionRadius);
+
+	std::vector<float> initialMap((size_t)mapWidth * mapHeight);
+	erosionMaker->GenerateNoise(initialMap.data(), mapWidth, mapHeight, NoiseParameters());
+	erosionMaker->ShapeIsland(initialMap.data(), initialMap.data(), nullptr, mapWidth, mapHeight, GradientType::SQUARE);
+
+	// memory touched by a step at random nodes away from the borders: the cache lines a cold step misses
+	int radius = erosionMaker->parameters.erosionRadius;
+	std::vector<size_t> lines, pages;
+	double rowLines = 0.0, rowPages = 0.0, tiledLines = 0.0, tiledPages = 0.0;
+	const int samples = 10000;
+	srand(42);
+	for (int sample = 0; sample < samples; sample++)
+	{
+		int nodeX = radius + rand() % std::max(mapWidth - 2 * radius - 1, 1);
+		int nodeY = radius + rand() % std::max(mapHeight - 2 * radius - 1, 1);
+		CountStepFootprint(RowMajorLayout(mapWidth), nodeX, nodeY, radius, &lines, &pages);
+		rowLines += lines.size();
+		rowPages += pages.size();
+		CountStepFootprint(TiledLayout(mapWidth, mapHeight), nodeX, nodeY, radius, &lines, &pages);
+		tiledLines += lines.size();
+		tiledPages += pages.size();
+	}
+	printf("row-major: %.1f cache lines, %.1f pages per step\n", rowLines / samples, rowPages / samples);
+	printf("tiled:     %.1f cache lines, %.1f pages per step\n", tiledLines / samples, tiledPages / samples);
+
+	// same seed and droplets with both layouts, the maps must come out identical
+	std::vector<float> maps[2];
+	const HeightmapLayout layouts[2] = { HeightmapLayout::ROW_MAJOR, HeightmapLayout::TILED };
+	const char* names[2] = { "row-major", "tiled" };
+	for (int i = 0; i < 2; i++)
+	{
+		maps[i] = initialMap;
+		erosionMaker->parameters.layout = layouts[i];
+		erosionMaker->SetSeed(42);
+		erosionMaker->Erode(&maps[i], mapWidth, mapHeight, BENCHMARK_DROPLETS, false);
+		printf("%-10s %.0f droplets/s\n", names[i], erosionMaker->dropletsPerSecond);
+	}
+	erosionMaker->parameters.layout = HeightmapLayout::ROW_MAJOR;
+	printf("maps %s\n", (maps[0] == maps[1]) ? "identical" : "DIFFER");
+}
+
+// runs the microbenchmark suite of the erosion maker and tree placement, JSON results on stdout and a summary on stderr
+static void RunBenchmark()
+{
+	ErosionMaker* erosionMaker = &ErosionMaker::GetInstance();
+	ErosionBenchmark benchmark(erosionMaker, [erosionMaker](std::vector<float>* map, int mapWidth, int mapHeight)
+	{
+		erosionMaker->GenerateNoise(map->data(), mapWidth, mapHeight, NoiseParameters()); // the noise of the application
+	});
+	benchmark.AddErosionMakerCases();
+
+	// tree placement on the island, textures are only copied into the billboards so empty ones will do
+	const int treeMapSize = MAP_DEFAULT_SIZE;
+	std::vector<float> treeMap;
+	NormalMap treeNormals(treeMapSize, treeMapSize);
+	std::vector<TreeBillboard> trees;
+	Texture2D treeTextures[TREE_TEXTURE_COUNT] = {};
+	BenchmarkCase treeCase;
+	treeCase.name = "GenerateTrees";
+	treeCase.parameters = "\"size\": " + std::to_string(treeMapSize);
+	treeCase.itemsPerRun = TREE_COUNT;
+	treeCase.unit = "trees";
+	treeCase.setup = [&]()
+	{
+		treeMap = benchmark.GetMap(treeMapSize, treeMapSize);
+		treeNormals.Calculate(treeMap); // kept up to date by the heightmap texture in the application
+		trees.clear();
+		srand(ErosionBenchmark::SEED);
+	};
+	treeCase.run = [&]()
+	{
+		GenerateTrees(treeNormals, &treeMap, treeMapSize, treeMapSize, treeTextures, &trees, true);
+	};
+	benchmark.AddCase(treeCase);
+
+	benchmark.Run(stdout, stderr);
+}
+
+int main(int argc, char** argv)
+{
+	GeneratorSettings settings;
+	ErosionParameters parameters;
+	if (!ParseArguments(argc, argv, &settings, &parameters))
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+	if (settings.batchPath != nullptr)
+		return RunBatch(settings, parameters);
+
+	ErosionMaker* erosionMaker = &ErosionMaker::GetInstance();
+	erosionMaker->parameters = parameters;
+	if (settings.verify || settings.printGoldenHashes)
+	{
+		ErosionVerification verification(erosionMaker);
+		if (settings.printGoldenHashes)
+		{
+			verification.PrintGoldenHashes(stdout);
+			return 0;
+		}
+		return verification.Run(stdout) ? 0 : 3;
+	}
+	if (settings.benchmark)
+	{
+		RunBenchmark();
+		return 0;
+	}
+	if (settings.layoutBenchmark)
+	{
+		if (settings.mapSizeGiven)
+			RunLayoutBenchmark(settings.mapWidth, settings.mapHeight);
+		else
+			RunLayoutBenchmark(BENCHMARK_MAP_SIZE, BENCHMARK_MAP_SIZE);
+		return 0;
+	}
+	if (!settings.remapPoints.empty())
+		erosionMaker->remapCurve.SetPoints(settings.remapPoints, settings.remapInterpolation);
+	int mapWidth = settings.mapWidth;
+	int mapHeight = settings.mapHeight;
+	erosionMaker->parameters.pipeCellLength = 4.0f / mapWidth; // same scale as the interactive application
+	erosionMaker->parameters.thermalCellLength = 4.0f / mapWidth;
+	int threads = erosionMaker->parameters.threadCount > 0 ? erosionMaker->parameters.threadCount : ThreadPool::GetHardwareThreadCount();
+	const char* iterationName = (erosionMaker->parameters.model == ErosionModel::PIPES) ? "pipe iterations" : "droplets";
+	if (!settings.quiet)
+		printf("terrain: %ix%i, seed %u, %lld %s, %i threads\n", mapWidth, mapHeight, settings.seed, settings.droplets, iterationName, threads);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<float> map((size_t)mapWidth * mapHeight);
+	NoiseParameters noise = settings.noise;
+	noise.seed = settings.seed;
+	erosionMaker->GenerateNoise(map.data(), mapWidth, mapHeight, noise);
+	double noiseSeconds = SecondsSince(begin);
+
+	begin = std::chrono::steady_clock::now();
+	erosionMaker->ShapeIsland(map.data(), map.data(), nullptr, mapWidth, mapHeight, settings.gradient);
+	double shapeSeconds = SecondsSince(begin);
+
+	begin = std::chrono::steady_clock::now();
+	erosionMaker->SetSeed(settings.seed);
+	erosionMaker->ResetDropletStatistics();
+	long long simulated = 0;
+	if (settings.multiresolutionLevels > 0)
+	{
+		int droplets = (int)std::min(settings.droplets, (long long)INT_MAX);
+		simulated = erosionMaker->ErodeMultiresolution(&map, mapWidth, mapHeight, droplets, settings.multiresolutionLevels).done;
+	}
+	else
+	{
+		// one batch after the other, the droplet sequence continues from batch to batch
+		while (simulated < settings.droplets)
+		{
+			int batch = (int)std::min((long long)ERODE_BATCH_DROPLETS, settings.droplets - simulated);
+			erosionMaker->Erode(&map, mapWidth, mapHeight, batch, false);
+			simulated += batch;
+			if (!settings.quiet && settings.droplets > ERODE_BATCH_DROPLETS)
+			{
+				printf("\r  %lld / %lld %s", simulated, settings.droplets, iterationName);
+				fflush(stdout);
+			}
+		}
+		if (!settings.quiet && settings.droplets > ERODE_BATCH_DROPLETS)
+			printf("\n");
+	}
+	double erodeSeconds = SecondsSince(begin);
+
+	begin = std::chrono::steady_clock::now();
+	if (settings.thermalIterations > 0)
+		erosionMaker->ErodeThermal(&map, mapWidth, mapHeight, settings.thermalIterations);
+	double thermalSeconds = SecondsSince(begin);
+
+	begin = std::chrono::steady_clock::now();
+	if (!WriteHeightmap(settings.outputPath, map, mapWidth, mapHeight))
+	{
+		fprintf(stderr, "could not write %s\n", settings.outputPath);
+		return 2;
+	}
+	double writeSeconds = SecondsSince(begin);
+
+	if (!settings.quiet)
+	{
+		printf("noise    %8.3f s\n", noiseSeconds);
+		printf("shape    %8.3f s (gradient and remap)\n", shapeSeconds);
+		printf("erode    %8.3f s (%lld %s, %.0f/s)\n", erodeSeconds, simulated, iterationName, erodeSeconds > 0.0 ? simulated / erodeSeconds : 0.0);
+		if (settings.thermalIterations > 0)
+			printf("thermal  %8.3f s (%i iterations)\n", thermalSeconds, settings.thermalIterations);
+		printf("write    %8.3f s (%s)\n", writeSeconds, settings.outputPath);
+	}
+	if (settings.statistics)
+		PrintDropletStatistics(erosionMaker->GetDropletStatistics());
+	return 0;
+}
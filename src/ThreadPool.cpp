@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+static thread_local bool insidePool = false; // true on pool workers and while the caller is running tasks
+
+ThreadPool::ThreadPool()
+{
+	nextIndex = 0;
+	int workerCount = GetHardwareThreadCount() - 1; // calling thread counts as a worker too
+	for (int i = 0; i < workerCount; i++)
+	{
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i + 1));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		quit = true;
+	}
+	jobStarted.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+int ThreadPool::GetHardwareThreadCount()
+{
+	unsigned int count = std::thread::hardware_concurrency();
+	return count > 0 ? (int)count : 1; // hardware_concurrency is allowed to return 0 when unknown
+}
+
+void ThreadPool::ParallelFor(int count, int maxThreads, const std::function<void(int index, int worker)>& task)
+{
+	if (count <= 0)
+		return;
+
+	int threads = (maxThreads <= 0) ? GetThreadCount() : std::min(maxThreads, GetThreadCount());
+	threads = std::min(threads, count);
+
+	// run inline when there's nothing to gain or when the workers are not available
+	std::unique_lock<std::mutex> callLock(callMutex, std::defer_lock);
+	if (threads <= 1 || insidePool || !callLock.try_lock())
+	{
+		bool wasInside = insidePool;
+		insidePool = true;
+		for (int i = 0; i < count; i++)
+		{
+			task(i, 0);
+		}
+		insidePool = wasInside;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobTask = &task;
+		jobCount = count;
+		jobThreads = threads;
+		nextIndex = 0;
+		busyWorkers = threads - 1;
+		jobGeneration++;
+	}
+	jobStarted.notify_all();
+
+	insidePool = true;
+	RunTasks(0);
+	insidePool = false;
+
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobFinished.wait(lock, [this] { return busyWorkers == 0; });
+	jobTask = nullptr;
+}
+
+void ThreadPool::WorkerLoop(int worker)
+{
+	insidePool = true;
+	unsigned int seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobStarted.wait(lock, [this, &seenGeneration] { return quit || jobGeneration != seenGeneration; });
+			if (quit)
+				return;
+			seenGeneration = jobGeneration;
+			if (worker >= jobThreads)
+				continue; // not needed for this job
+		}
+
+		RunTasks(worker);
+
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			busyWorkers--;
+		}
+		jobFinished.notify_one();
+	}
+}
+
+void ThreadPool::RunTasks(int worker)
+{
+	// indices are handed out one at a time so uneven tasks (tiles with more droplets) balance themselves
+	while (true)
+	{
+		int index = nextIndex.fetch_add(1);
+		if (index >= jobCount)
+			break;
+		(*jobTask)(index, worker);
+	}
+}
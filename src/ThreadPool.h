@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// persistent pool of worker threads used to run data-parallel loops
+// workers are created once and sleep between jobs, so small jobs (a few hundred droplets per frame) don't pay thread creation
+class ThreadPool
+{
+public:
+	static ThreadPool& GetInstance()
+	{
+		static ThreadPool instance; // shared by every module, created on first use
+		return instance;
+	}
+
+	ThreadPool(ThreadPool const&) = delete;
+	void operator=(ThreadPool const&) = delete;
+
+	// runs task(index, worker) for every index in [0, count) using at most maxThreads threads (0 = all hardware threads)
+	// worker is in range [0, GetThreadCount()) and can be used to address per-thread scratch data
+	// the calling thread takes part in the work; calls made from inside a task (or while the pool is busy) run serially
+	void ParallelFor(int count, int maxThreads, const std::function<void(int index, int worker)>& task);
+
+	// runs rowTask(firstRow, lastRow) on bands of rowsPerTask rows of a grid, used by full-map passes
+	template <class RowTask>
+	void ParallelForRows(int rows, int rowsPerTask, int maxThreads, const RowTask& rowTask)
+	{
+		int tasks = (rows + rowsPerTask - 1) / rowsPerTask;
+		ParallelFor(tasks, maxThreads, [&](int task, int worker)
+		{
+			int firstRow = task * rowsPerTask;
+			rowTask(firstRow, std::min(firstRow + rowsPerTask, rows));
+		});
+	}
+
+	int GetThreadCount() const { return (int)workers.size() + 1; } // workers plus the calling thread
+	static int GetHardwareThreadCount();
+
+private:
+	ThreadPool();
+	~ThreadPool();
+
+	void WorkerLoop(int worker);
+	void RunTasks(int worker);
+
+	std::vector<std::thread> workers;
+	std::mutex callMutex; // only one ParallelFor can own the workers at a time
+	std::mutex jobMutex;
+	std::condition_variable jobStarted;
+	std::condition_variable jobFinished;
+
+	// current job
+	const std::function<void(int, int)>* jobTask = nullptr;
+	int jobCount = 0;
+	int jobThreads = 0; // workers allowed to take part in current job
+	unsigned int jobGeneration = 0; // incremented for every new job
+	std::atomic<int> nextIndex;
+	int busyWorkers = 0;
+	bool quit = false;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "TreeBillboards.h"
+#include <stdlib.h>
+#include <algorithm>
+
+// random float between two values
+float static randomRange(float min, float max) {
+	return min + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (max - min)));
+}
+
+void GenerateTrees(const NormalMap& normals, std::vector<float>* mapData, int mapWidth, int mapHeight, Texture2D* treeTextures, std::vector<TreeBillboard>* trees, bool generateNew)
+{
+	float terrainDepth = 32.0f * mapHeight / mapWidth;
+	Vector3 billPosition = { 0.0f, 0.0f, 0.0f };
+	Vector3 billNormal = { 0.0f, 0.0f, 0.0f };
+	float grassSlopeThreshold = 0.2; // different than in the terrain shader
+	float grassBlendAmount = 0.55;
+	float grassWeight;
+	Color billColor = WHITE;
+
+	for (size_t i = 0; i < TREE_COUNT; i++) // 8190 max billboards, more than that and they are not cached anymore
+	{
+		int px, py;
+		do
+		{
+			// try to generate a billboard
+			billPosition.x = randomRange(-16, 16);
+			billPosition.z = randomRange(-terrainDepth / 2, terrainDepth / 2);
+			px = ((billPosition.x + 16.0f) / 32.0f) * (mapWidth - 1);
+			py = (billPosition.z / terrainDepth + 0.5f) * (mapHeight - 1);
+			billNormal = normals.GetNormal(px, py);
+			billPosition.y = mapData->at((size_t)py * mapWidth + px) * 8 - 1.1f;
+
+			float slope = 1.0 - billNormal.y;
+			float grassBlendHeight = grassSlopeThreshold * (1.0 - grassBlendAmount);
+			grassWeight = 1.0 - std::min(std::max((slope - grassBlendHeight) / (grassSlopeThreshold - grassBlendHeight), 0.0f), 1.0f);
+		} while (billPosition.y < 0.32f || billPosition.y > 3.25f || grassWeight < 0.65f); // repeat until you find valid parameters (height and normal of chosen spot)
+
+		billColor.r = (billNormal.x + 1) * 127.5f; // terrain normal where tree is located, stored on color
+		billColor.g = (billNormal.y + 1) * 127.5f; // convert from range (-1, 1) to (0, 255)
+		billColor.b = (billNormal.z + 1) * 127.5f;
+
+		if (!generateNew)
+		{
+			(*trees)[i].position = billPosition;
+			(*trees)[i].color = billColor;
+		}
+		else
+		{
+			int textureChoice = (int)randomRange(0, TREE_TEXTURE_COUNT);
+			trees->push_back({ treeTextures[textureChoice], billPosition, randomRange(0.6f, 1.4f) * 0.3f, billColor });
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef TREE_BILLBOARDS
+#define TREE_BILLBOARDS
+
+#include <vector>
+#include "raylib.h"
+#include "NormalMap.h"
+
+#define TREE_TEXTURE_COUNT		19 // number of textures for a tree
+#define TREE_COUNT				8190 // number of tree billboards
+
+// defines a tree billboard
+typedef struct
+{
+	Texture2D texture;
+	Vector3 position;
+	float scale = 1.0f;
+	Color color = WHITE;
+} TreeBillboard;
+
+// generates (or regenerates) all tree billboards on grassy spots of the island, positions from rand().
+// only fills the billboards, nothing is drawn or loaded, so it also runs without a window (benchmark of terrain_generator)
+void GenerateTrees(const NormalMap& normals, std::vector<float>* mapData, int mapWidth, int mapHeight, Texture2D* treeTextures, std::vector<TreeBillboard>* trees, bool generateNew);
+
+#endif